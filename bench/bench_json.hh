@@ -0,0 +1,357 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// JSON result files of the benchmarks.
+//
+//   {
+//     "suite": "kernel_bench",
+//     "metadata": {"date": ..., "cpu": ..., "compiler": ..., ...},
+//     "results": [
+//       {"name": "C++/partition/int32/functor/1024/warm",
+//        "unit": "ns/elem", "samples": [1.68, 1.71, ...],
+//        "extra": {"cycles": 3.2, ...}},
+//       ...
+//     ]
+//   }
+//
+// A result is a workload identified by its name, with the samples of
+// the repetitions; bench/compare.cc compares two files by the names.
+// The minimal parser below reads these files.
+// ======================================================
+
+#ifndef QUICKSORT_MM_BENCH_JSON_HH_INCLUDED
+#define QUICKSORT_MM_BENCH_JSON_HH_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+  struct json_result {
+    std::string name;
+    std::string unit;
+    std::vector<double> samples;
+    std::vector<std::pair<std::string, double> > extra;
+  };
+
+
+  // ======================================================
+  // Metadata of the machine and the build
+  // ======================================================
+  inline std::string cpu_model()
+  {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.compare(0, 10, "model name") == 0) {
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) return line.substr(line.find_first_not_of(" \t", colon+1));
+      }
+    }
+    return "unknown";
+  }
+
+  inline std::vector<std::pair<std::string, std::string> > metadata()
+  {
+    std::vector<std::pair<std::string, std::string> > m;
+
+    char date[32];
+    std::time_t t = std::time(nullptr);
+    std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+    m.emplace_back("date", date);
+
+#if defined(__unix__) || defined(__APPLE__)
+    char host[256] = "";
+    gethostname(host, sizeof host - 1);
+    m.emplace_back("host", host);
+    utsname u;
+    if (uname(&u) == 0) m.emplace_back("os", std::string(u.sysname) + " " + u.release + " " + u.machine);
+#endif
+    m.emplace_back("cpu", cpu_model());
+    m.emplace_back("threads", std::to_string(std::thread::hardware_concurrency()));
+
+#if defined(__clang__)
+    m.emplace_back("compiler", "clang " __clang_version__);
+#elif defined(__GNUC__)
+    m.emplace_back("compiler", "gcc " __VERSION__);
+#elif defined(_MSC_VER)
+    m.emplace_back("compiler", "msvc " + std::to_string(_MSC_VER));
+#else
+    m.emplace_back("compiler", "unknown");
+#endif
+    m.emplace_back("cplusplus", std::to_string(__cplusplus));
+
+    std::string flags;
+#if defined(__OPTIMIZE__)
+    flags += " __OPTIMIZE__";
+#endif
+#if defined(NDEBUG)
+    flags += " NDEBUG";
+#endif
+#if defined(QUICKSORT_MM_PHASE_HOOKS)
+    flags += " QUICKSORT_MM_PHASE_HOOKS";
+#endif
+#if defined(QUICKSORT_MM_USDT)
+    flags += " QUICKSORT_MM_USDT";
+#endif
+    m.emplace_back("flags", flags.empty() ? flags : flags.substr(1));
+    return m;
+  }
+
+
+  // ======================================================
+  // Writer
+  // ======================================================
+  inline std::string json_string(const std::string &s)
+  {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+        out += char(c);
+      }
+      else if (c < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof buf, "\\u%04x", c);
+        out += buf;
+      }
+      else {
+        out += char(c);
+      }
+    }
+    return out + "\"";
+  }
+
+  // Write the results to path; it returns false on failure.
+  inline bool write_json(const std::string &path, const std::string &suite, const std::vector<json_result> &results)
+  {
+    FILE *f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    std::fprintf(f, "{\n  \"suite\": %s,\n  \"metadata\": {", json_string(suite).c_str());
+    const char *sep = "\n";
+    for (auto &kv : metadata()) {
+      std::fprintf(f, "%s    %s: %s", sep, json_string(kv.first).c_str(), json_string(kv.second).c_str());
+      sep = ",\n";
+    }
+    std::fprintf(f, "\n  },\n  \"results\": [");
+    sep = "\n";
+    for (auto &r : results) {
+      std::fprintf(f, "%s    {\"name\": %s, \"unit\": %s, \"samples\": [",
+                   sep, json_string(r.name).c_str(), json_string(r.unit).c_str());
+      for (size_t i = 0; i < r.samples.size(); i++) std::fprintf(f, "%s%.6g", i ? ", " : "", r.samples[i]);
+      std::fprintf(f, "]");
+      if (!r.extra.empty()) {
+        std::fprintf(f, ", \"extra\": {");
+        for (size_t i = 0; i < r.extra.size(); i++) {
+          std::fprintf(f, "%s%s: %.6g", i ? ", " : "", json_string(r.extra[i].first).c_str(), r.extra[i].second);
+        }
+        std::fprintf(f, "}");
+      }
+      std::fprintf(f, "}");
+      sep = ",\n";
+    }
+    std::fprintf(f, "\n  ]\n}\n");
+    return std::fclose(f) == 0;
+  }
+
+
+  // ======================================================
+  // Parser
+  // ======================================================
+  struct json_value {
+    enum kind_type { null, boolean, number, string, array, object };
+
+    kind_type kind = null;
+    bool b = false;
+    double num = 0;
+    std::string str;
+    std::vector<json_value> items;
+    std::map<std::string, json_value> members;
+
+    // The member of the key, or null if absent
+    const json_value &operator[](const std::string &key) const
+    {
+      static const json_value none;
+      auto it = members.find(key);
+      return it == members.end() ? none : it->second;
+    }
+  };
+
+  class json_parser {
+  public:
+    explicit json_parser(const std::string &text) : s_(text), pos_(0) {}
+
+    json_value parse()
+    {
+      json_value v = value();
+      skip();
+      if (pos_ != s_.size()) fail("trailing characters");
+      return v;
+    }
+
+  private:
+    [[noreturn]] void fail(const char *what)
+    {
+      throw std::runtime_error("JSON: " + std::string(what) + " at offset " + std::to_string(pos_));
+    }
+
+    void skip()
+    {
+      while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\n' || s_[pos_] == '\r')) pos_++;
+    }
+
+    bool eat(char c)
+    {
+      skip();
+      if (pos_ < s_.size() && s_[pos_] == c) {
+        pos_++;
+        return true;
+      }
+      return false;
+    }
+
+    void expect(char c)
+    {
+      if (!eat(c)) fail("unexpected character");
+    }
+
+    bool literal(const char *word)
+    {
+      std::string w(word);
+      if (s_.compare(pos_, w.size(), w) != 0) return false;
+      pos_ += w.size();
+      return true;
+    }
+
+    json_value value()
+    {
+      json_value v;
+      skip();
+      if (pos_ >= s_.size()) fail("unexpected end");
+      char c = s_[pos_];
+      if (c == '{') {
+        pos_++;
+        v.kind = json_value::object;
+        if (eat('}')) return v;
+        do {
+          skip();
+          std::string key = string_body();
+          expect(':');
+          v.members[key] = value();
+        } while (eat(','));
+        expect('}');
+      }
+      else if (c == '[') {
+        pos_++;
+        v.kind = json_value::array;
+        if (eat(']')) return v;
+        do {
+          v.items.push_back(value());
+        } while (eat(','));
+        expect(']');
+      }
+      else if (c == '"') {
+        v.kind = json_value::string;
+        v.str = string_body();
+      }
+      else if (literal("true")) {
+        v.kind = json_value::boolean;
+        v.b = true;
+      }
+      else if (literal("false")) {
+        v.kind = json_value::boolean;
+      }
+      else if (literal("null")) {
+      }
+      else {
+        const char *begin = s_.c_str() + pos_;
+        char *end;
+        v.kind = json_value::number;
+        v.num = std::strtod(begin, &end);
+        if (end == begin) fail("invalid value");
+        pos_ += size_t(end - begin);
+      }
+      return v;
+    }
+
+    // A string starting at pos_; \u escapes are kept as ASCII only.
+    std::string string_body()
+    {
+      if (pos_ >= s_.size() || s_[pos_] != '"') fail("string expected");
+      pos_++;
+      std::string out;
+      while (pos_ < s_.size() && s_[pos_] != '"') {
+        char c = s_[pos_++];
+        if (c != '\\') {
+          out += c;
+          continue;
+        }
+        if (pos_ >= s_.size()) break;
+        char e = s_[pos_++];
+        switch (e) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u':
+          if (pos_ + 4 > s_.size()) fail("invalid escape");
+          out += char(std::strtol(s_.substr(pos_, 4).c_str(), nullptr, 16) & 0x7f);
+          pos_ += 4;
+          break;
+        default: out += e; break;
+        }
+      }
+      if (pos_ >= s_.size()) fail("unterminated string");
+      pos_++;
+      return out;
+    }
+
+    const std::string &s_;
+    size_t pos_;
+  };
+
+  inline json_value read_json(const std::string &path)
+  {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + path);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return json_parser(text).parse();
+  }
+
+
+  // The option "--json FILE" of the benchmarks
+  // It is removed from argv, and the file name (or "") is returned.
+  inline std::string json_option(int &argc, char **argv)
+  {
+    std::string path;
+    int j = 1;
+    for (int i = 1; i < argc; i++) {
+      if (std::string(argv[i]) == "--json" && i+1 < argc) path = argv[++i];
+      else argv[j++] = argv[i];
+    }
+    argc = j;
+    return path;
+  }
+}
+
+#endif
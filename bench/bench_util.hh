@@ -0,0 +1,60 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Utilities shared by the benchmarks.
+// ======================================================
+
+#ifndef QUICKSORT_MM_BENCH_UTIL_HH_INCLUDED
+#define QUICKSORT_MM_BENCH_UTIL_HH_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace bench {
+  // Wall time in seconds
+  inline double now()
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Distinct 32bits-integers in random order, as in the README.
+  inline std::vector<int> distinct_ints(size_t n, uint64_t seed)
+  {
+    std::vector<int> v(n);
+    // i -> i*a mod 2^32 is a bijection for odd a.
+    for (size_t i = 0; i < n; i++) v[i] = int(uint32_t(i) * 2654435761u);
+    std::mt19937_64 rng(seed);
+    std::shuffle(v.begin(), v.end(), rng);
+    return v;
+  }
+
+  inline int cmp_int(const void *a, const void *b)
+  {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+  }
+
+  // Keep the compiler from removing the computation of x.
+  template<class T>
+  inline void do_not_optimize(const T &x)
+  {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&x) : "memory");
+#else
+    volatile const T *p = &x;
+    (void)p;
+#endif
+  }
+}
+
+#endif
@@ -0,0 +1,196 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Comparison of two JSON result files of the benchmarks.
+//
+// For each workload in both files, the samples (lower is better) are
+// compared by
+// * the two-sided Mann-Whitney U test (normal approximation with the
+//   tie and continuity corrections), and
+// * the bootstrap 95% confidence interval of the ratio of the medians.
+// A change is flagged when p < alpha, the interval excludes 1, and the
+// ratio differs from 1 by the threshold or more. With fewer than about
+// 8 samples per side, the test rarely reaches a small p.
+//
+// The exit status is 2 if some workload got slower, so that it can
+// gate an upgrade; 1 on errors.
+//
+//   c++ -std=c++11 -O2 -Isrc/cc bench/compare.cc -o compare
+//   ./compare [--alpha 0.01] [--threshold 0.02] base.json new.json
+// ======================================================
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bench_json.hh"
+#include "quicksort_mm.hh"
+
+namespace {
+  typedef std::map<std::string, std::vector<double> > workloads;
+
+  double median(std::vector<double> v)
+  {
+    size_t n = v.size();
+    quicksort_mm::quickselect(v.begin(), v.begin() + n/2, v.end());
+    double m = v[n/2];
+    if (n % 2 == 0) {
+      quicksort_mm::quickselect(v.begin(), v.begin() + n/2 - 1, v.begin() + n/2);
+      m = (m + v[n/2 - 1]) / 2;
+    }
+    return m;
+  }
+
+  // Two-sided p-value of the Mann-Whitney U test
+  double mann_whitney(const std::vector<double> &a, const std::vector<double> &b)
+  {
+    size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    std::vector<std::pair<double, int> > all;
+    for (double x : a) all.emplace_back(x, 0);
+    for (double x : b) all.emplace_back(x, 1);
+    quicksort_mm::quicksort(all.begin(), all.end());
+
+    // Average ranks of the ties
+    double r1 = 0, ties = 0;
+    for (size_t i = 0; i < n; ) {
+      size_t j = i;
+      while (j < n && all[j].first == all[i].first) j++;
+      double rank = (double(i + 1) + double(j)) / 2;
+      for (size_t k = i; k < j; k++) {
+        if (all[k].second == 0) r1 += rank;
+      }
+      double t = double(j - i);
+      ties += t*t*t - t;
+      i = j;
+    }
+
+    double u = r1 - double(n1) * double(n1 + 1) / 2;
+    double mean = double(n1) * double(n2) / 2;
+    double var = double(n1) * double(n2) / 12 * (double(n + 1) - ties / (double(n) * double(n - 1)));
+    if (var <= 0) return 1;
+    double z = (std::fabs(u - mean) - 0.5) / std::sqrt(var);
+    if (z < 0) z = 0;
+    return std::erfc(z / std::sqrt(2.0));
+  }
+
+  // Bootstrap 95% interval of median(b)/median(a)
+  std::pair<double, double> bootstrap_ratio(const std::vector<double> &a, const std::vector<double> &b,
+                                            int rounds = 2000)
+  {
+    std::mt19937_64 rng(12345);
+    std::vector<double> ratios, ra(a.size()), rb(b.size());
+    for (int k = 0; k < rounds; k++) {
+      for (auto &x : ra) x = a[rng() % a.size()];
+      for (auto &x : rb) x = b[rng() % b.size()];
+      double ma = median(ra);
+      if (ma > 0) ratios.push_back(median(rb) / ma);
+    }
+    if (ratios.empty()) return std::make_pair(NAN, NAN);
+    quicksort_mm::quicksort(ratios.begin(), ratios.end());
+    return std::make_pair(ratios[size_t(0.025 * double(ratios.size() - 1))],
+                          ratios[size_t(0.975 * double(ratios.size() - 1))]);
+  }
+
+  // The workloads, in the order of the file
+  std::vector<std::string> load(const std::string &path, workloads &w, bench::json_value &meta)
+  {
+    auto root = bench::read_json(path);
+    meta = root["metadata"];
+    std::vector<std::string> names;
+    for (auto &r : root["results"].items) {
+      std::vector<double> samples;
+      for (auto &x : r["samples"].items) samples.push_back(x.num);
+      const std::string &name = r["name"].str;
+      if (samples.empty() || w.count(name)) continue;
+      w[name] = samples;
+      names.push_back(name);
+    }
+    return names;
+  }
+
+  void usage(const char *prog)
+  {
+    std::fprintf(stderr, "usage: %s [--alpha A] [--threshold T] base.json new.json\n", prog);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  double alpha = 0.01, threshold = 0.02;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--alpha" && i+1 < argc) alpha = std::atof(argv[++i]);
+    else if (arg == "--threshold" && i+1 < argc) threshold = std::atof(argv[++i]);
+    else files.push_back(arg);
+  }
+  if (files.size() != 2) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  workloads base, next;
+  bench::json_value base_meta, next_meta;
+  std::vector<std::string> names;
+  try {
+    names = load(files[0], base, base_meta);
+    load(files[1], next, next_meta);
+  }
+  catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  for (auto &kv : base_meta.members) {
+    const std::string &v = next_meta[kv.first].str;
+    if (kv.first != "date" && kv.second.str != v) {
+      std::printf("# %s: %s -> %s\n", kv.first.c_str(), kv.second.str.c_str(), v.c_str());
+    }
+  }
+
+  int slower = 0, faster = 0;
+  std::printf("%-48s %11s %11s %8s %19s %9s\n", "workload", "base", "new", "change", "95% CI", "p");
+  for (auto &name : names) {
+    auto it = next.find(name);
+    if (it == next.end()) continue;
+    auto &a = base[name];
+    auto &b = it->second;
+
+    double ma = median(a), mb = median(b);
+    double ratio = mb / ma;
+    auto ci = bootstrap_ratio(a, b);
+    double p = mann_whitney(a, b);
+
+    const char *verdict = "";
+    if (p < alpha && !(ci.first <= 1 && 1 <= ci.second) && std::fabs(ratio - 1) >= threshold) {
+      if (ratio > 1) {
+        verdict = "SLOWER";
+        slower++;
+      }
+      else {
+        verdict = "faster";
+        faster++;
+      }
+    }
+    std::printf("%-48s %11.4g %11.4g %+7.1f%% [%7.3f, %7.3f] %9.2g %s\n",
+                name.c_str(), ma, mb, (ratio - 1) * 100, ci.first, ci.second, p, verdict);
+  }
+
+  for (auto &name : names) {
+    if (!next.count(name)) std::printf("# only in %s: %s\n", files[0].c_str(), name.c_str());
+  }
+  for (auto &kv : next) {
+    if (!base.count(kv.first)) std::printf("# only in %s: %s\n", files[1].c_str(), kv.first.c_str());
+  }
+  std::printf("# %d slower, %d faster (alpha = %g, threshold = %g)\n", slower, faster, alpha, threshold);
+  return slower > 0 ? 2 : 0;
+}
@@ -0,0 +1,274 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Microbenchmarks of the kernels.
+//
+// median3, median5, partition, the leaf sort (insertion_sort in C++)
+// and the group loop of rs3_5_2_pick_pivot are measured alone, for
+// the C and C++ versions, element types, sizes and comparators:
+// * functor:   a function object, inlined;
+// * fptr:      a function pointer bool(*)(const T &, const T &);
+// * three-way: a lambda returning std::weak_ordering (C++20);
+// * C:         the comparator int(*)(const void *, const void *).
+//
+// The instances of a kernel are run in batches of about batch_size
+// elements. The inputs are restored before each batch, which leaves
+// them in the cache (warm); for "cold", a large buffer is written
+// after that to evict them. The median and the minimum of the time
+// per element visited (by the groups for gather_medians) over the
+// repetitions are reported.
+//
+// It builds as C++11; the three-way rows are measured with -std=c++20.
+//
+//   cc -std=c99 -O3 -DNDEBUG -Isrc/c -c bench/kernels_c.c
+//   c++ -std=c++11 -O3 -DNDEBUG -Isrc/c -Isrc/cc bench/kernel_bench.cc kernels_c.o -o kernel_bench
+//   ./kernel_bench [--json FILE] [repeat]
+// ======================================================
+
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bench_json.hh"
+#include "bench_util.hh"
+#include "quicksort_mm.hh"
+
+extern "C" {
+  typedef int (*c_comparator)(const void *, const void *);
+  char *bench_c_median3(char *p, char *q, char *r, c_comparator cmp);
+  char *bench_c_median5(char *a, char *b, char *c, char *d, char *e, c_comparator cmp);
+  char *bench_c_partition(char *begin, char *pivot, size_t n, size_t sz, c_comparator cmp);
+  void bench_c_small_sort(char *p, size_t n, size_t sz, c_comparator cmp);
+  void bench_c_gather_medians(char *p, size_t n, size_t sz, size_t thin, c_comparator cmp);
+}
+
+namespace {
+  const size_t batch_size = size_t(1) << 14;
+  const size_t evict_size = size_t(64) << 20;
+  const size_t max_input = size_t(64) << 20;
+  int repeat = 11;
+
+  struct result {
+    std::string lang, kernel, type, cmp, cache;
+    size_t n;
+    std::vector<double> ns;  // time per element of each repetition
+  };
+
+  // ======================================================
+  // Element types
+  // ======================================================
+  struct rec16 {
+    uint64_t key;
+    uint64_t payload;
+  };
+
+  inline int key(int x) { return x; }
+  inline double key(double x) { return x; }
+  inline uint64_t key(const rec16 &x) { return x.key; }
+
+  template<class T> T make(int x);
+  template<> int make<int>(int x) { return x; }
+  template<> double make<double>(int x) { return double(x) * 0.5; }
+  template<> rec16 make<rec16>(int x) { return rec16{uint64_t(uint32_t(x)), 0}; }
+
+  template<class T> const char *type_name();
+  template<> const char *type_name<int>() { return "int32"; }
+  template<> const char *type_name<double>() { return "double"; }
+  template<> const char *type_name<rec16>() { return "rec16"; }
+
+  template<class T>
+  struct key_less {
+    bool operator()(const T &a, const T &b) const { return key(a) < key(b); }
+  };
+
+  template<class T>
+  bool less_fn(const T &a, const T &b) { return key(a) < key(b); }
+
+  template<class T>
+  int cmp_c(const void *a, const void *b)
+  {
+    auto x = key(*(const T *)a);
+    auto y = key(*(const T *)b);
+    return (x > y) - (x < y);
+  }
+
+
+  // ======================================================
+  // Measurement
+  // ======================================================
+  std::vector<char> evict_buffer;
+  uintptr_t sink;
+
+  void evict()
+  {
+    if (evict_buffer.empty()) evict_buffer.resize(evict_size);
+    std::memset(evict_buffer.data(), int(sink & 0xff), evict_buffer.size());
+    bench::do_not_optimize(evict_buffer);
+  }
+
+  // Run kernel(p, n) on the consecutive instances of n elements.
+  // The time is divided by the elements visited: visited per instance, or n if 0.
+  template<class T, class Kernel>
+  void measure(std::vector<result> &out, const char *lang, const char *kernel, const char *cmp,
+               size_t n, Kernel run, size_t visited = 0)
+  {
+    if (visited == 0) visited = n;
+    // At least batch_size elements visited, within max_input bytes
+    size_t count = visited < batch_size ? batch_size / visited : 1;
+    if (count > 1 && n*count*sizeof(T) > max_input) count = max_input / (n*sizeof(T));
+    if (count == 0) count = 1;
+    auto src = bench::distinct_ints(n*count, 1);
+    std::vector<T> input(n*count), work(n*count);
+    for (size_t i = 0; i < n*count; i++) input[i] = make<T>(src[i]);
+
+    for (int cold = 0; cold < 2; cold++) {
+      result r = {lang, kernel, type_name<T>(), cmp, cold ? "cold" : "warm", n, {}};
+      for (int k = 0; k < repeat; k++) {
+        std::memcpy(work.data(), input.data(), n*count*sizeof(T));
+        if (cold) evict();
+        double t = bench::now();
+        for (size_t i = 0; i < count; i++) run(work.data() + i*n, n);
+        t = bench::now() - t;
+        r.ns.push_back(t * 1e9 / double(visited*count));
+      }
+      bench::do_not_optimize(work);
+      out.push_back(r);
+    }
+  }
+
+  // Elements in the groups of rs3_5_2_pick_pivot at the top level
+  size_t gathered(size_t n)
+  {
+    return 15 * (n / (15 * quicksort_mm::approx_sqrt(n)));
+  }
+
+  // The kernels of the C++ version with a less-than comparator
+  template<class T, class Cmp>
+  void cc_kernels(std::vector<result> &out, const char *cmpname, Cmp cmp)
+  {
+    measure<T>(out, "C++", "median3", cmpname, 3, [&](T *p, size_t) {
+      sink += uintptr_t(quicksort_mm::median3(p, p+1, p+2, cmp));
+    });
+    measure<T>(out, "C++", "median5", cmpname, 5, [&](T *p, size_t) {
+      sink += uintptr_t(quicksort_mm::median5(p, p+1, p+2, p+3, p+4, cmp));
+    });
+    for (size_t n : {4, 8, 16, 32}) {
+      measure<T>(out, "C++", "insertion_sort", cmpname, n, [&](T *p, size_t n) {
+        quicksort_mm::insertion_sort(p, p+n, cmp);
+      });
+    }
+    for (size_t n : {size_t(1) << 10, size_t(1) << 14, size_t(1) << 18, size_t(1) << 20}) {
+      measure<T>(out, "C++", "partition", cmpname, n, [&](T *p, size_t n) {
+        sink += uintptr_t(quicksort_mm::partition(p, p+n, p+n/2, cmp));
+      });
+    }
+    for (size_t n : {size_t(1) << 14, size_t(1) << 18, size_t(1) << 20}) {
+      measure<T>(out, "C++", "gather_medians", cmpname, n, [&](T *p, size_t n) {
+        size_t s = quicksort_mm::approx_sqrt(n);
+        size_t nnext = n/(15*s);
+        quicksort_mm::rs3_5_2_gather_medians(p, p + 7*(n/15), p + n - 7*nnext, nnext, cmp);
+      }, gathered(n));
+    }
+  }
+
+  template<class T>
+  void c_kernels(std::vector<result> &out)
+  {
+    const size_t sz = sizeof(T);
+    c_comparator cmp = cmp_c<T>;
+    measure<T>(out, "C", "median3", "C", 3, [&](T *p, size_t) {
+      char *b = (char *)p;
+      sink += uintptr_t(bench_c_median3(b, b+sz, b+2*sz, cmp));
+    });
+    measure<T>(out, "C", "median5", "C", 5, [&](T *p, size_t) {
+      char *b = (char *)p;
+      sink += uintptr_t(bench_c_median5(b, b+sz, b+2*sz, b+3*sz, b+4*sz, cmp));
+    });
+    for (size_t n : {4, 8, 16, 32}) {
+      measure<T>(out, "C", "small_sort", "C", n, [&](T *p, size_t n) {
+        bench_c_small_sort((char *)p, n, sz, cmp);
+      });
+    }
+    for (size_t n : {size_t(1) << 10, size_t(1) << 14, size_t(1) << 18, size_t(1) << 20}) {
+      measure<T>(out, "C", "partition", "C", n, [&](T *p, size_t n) {
+        sink += uintptr_t(bench_c_partition((char *)p, (char *)(p + n/2), n, sz, cmp));
+      });
+    }
+    for (size_t n : {size_t(1) << 14, size_t(1) << 18, size_t(1) << 20}) {
+      measure<T>(out, "C", "gather_medians", "C", n, [&](T *p, size_t n) {
+        bench_c_gather_medians((char *)p, n, sz, quicksort_mm::approx_sqrt(n), cmp);
+      }, gathered(n));
+    }
+  }
+
+  template<class T>
+  void all_kernels(std::vector<result> &out)
+  {
+    cc_kernels<T>(out, "functor", key_less<T>());
+    cc_kernels<T>(out, "fptr", &less_fn<T>);
+#if __cplusplus >= 202002L
+    cc_kernels<T>(out, "three-way",
+                  quicksort_mm::to_less<T>([](const T &a, const T &b) { return std::weak_order(key(a), key(b)); }));
+#endif
+    c_kernels<T>(out);
+  }
+
+  double median(std::vector<double> v)
+  {
+    quicksort_mm::quickselect(v.begin(), v.begin() + v.size()/2, v.end());
+    return v[v.size()/2];
+  }
+
+  double minimum(const std::vector<double> &v)
+  {
+    double m = v[0];
+    for (double x : v) m = x < m ? x : m;
+    return m;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::string json = bench::json_option(argc, argv);
+  if (argc > 1) repeat = std::atoi(argv[1]);
+  if (repeat <= 0) {
+    std::fprintf(stderr, "usage: %s [--json FILE] [repeat]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<result> results;
+  all_kernels<int>(results);
+  all_kernels<double>(results);
+  all_kernels<rec16>(results);
+
+  std::printf("%-4s %-15s %-7s %-10s %8s %-5s %10s %10s\n",
+              "lang", "kernel", "type", "cmp", "n", "cache", "ns/elem", "min");
+  for (auto &r : results) {
+    std::printf("%-4s %-15s %-7s %-10s %8zu %-5s %10.3f %10.3f\n",
+                r.lang.c_str(), r.kernel.c_str(), r.type.c_str(), r.cmp.c_str(), r.n, r.cache.c_str(),
+                median(r.ns), minimum(r.ns));
+  }
+
+  if (!json.empty()) {
+    std::vector<bench::json_result> out;
+    for (auto &r : results) {
+      std::string name = r.lang + "/" + r.kernel + "/" + r.type + "/" + r.cmp + "/" + std::to_string(r.n) + "/" + r.cache;
+      out.push_back(bench::json_result{name, "ns/elem", r.ns, {}});
+    }
+    if (!bench::write_json(json, "kernel_bench", out)) {
+      std::fprintf(stderr, "cannot write %s\n", json.c_str());
+      return 1;
+    }
+  }
+  return int(sink & 0);
+}
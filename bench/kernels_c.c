@@ -0,0 +1,42 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+// ======================================================
+// Kernels of the C version exported for bench/kernel_bench.cc.
+//
+// This file includes quicksort_mm.c to reach its static routines, so
+// it is linked instead of quicksort_mm.o.
+// ======================================================
+
+#include "quicksort_mm.c"
+
+char *bench_c_median3(char *p, char *q, char *r, comparator cmp)
+{
+  return median3(p, q, r, cmp);
+}
+
+char *bench_c_median5(char *a, char *b, char *c, char *d, char *e, comparator cmp)
+{
+  return median5(a, b, c, d, e, cmp);
+}
+
+char *bench_c_partition(char *begin, char *pivot, size_t n, size_t sz, comparator cmp)
+{
+  return partition(begin, pivot, n, sz, cmp);
+}
+
+// The leaf sort of quicksort_body
+void bench_c_small_sort(char *p, size_t n, size_t sz, comparator cmp)
+{
+  small_sort(p, n, sz, cmp);
+}
+
+// The group loop of rs3_5_2_pick_pivot with the layout of n elements
+void bench_c_gather_medians(char *p, size_t n, size_t sz, size_t thin, comparator cmp)
+{
+  size_t nnext = n/(15*thin);
+  rs3_5_2_gather_medians(p, p + 7*(n/15)*sz, p + (n-nnext*7)*sz, nnext, sz, cmp);
+}
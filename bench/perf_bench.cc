@@ -0,0 +1,175 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Benchmark with hardware performance counters.
+//
+// The C++ and C versions of quicksort and quickselect are run on
+// random sequences of distinct 32bits-integers, and the time and the
+// counters (see perf_counters.hh) per element are reported.
+//
+// When the both versions are compiled with QUICKSORT_MM_PHASE_HOOKS,
+// the counts are also split into the phases: the pivot selection, the
+// partition and the leaf sort (the rest is the recursion itself).
+// A phase is charged with everything inside it, including the nested
+// phases; reading the counters adds some work, mostly in the kernel,
+// which is not counted, and the time.
+//
+//   cc -std=c99 -O3 -DNDEBUG -DQUICKSORT_MM_PHASE_HOOKS -c src/c/quicksort_mm.c
+//   c++ -std=c++11 -O3 -DNDEBUG -DQUICKSORT_MM_PHASE_HOOKS -Isrc/c -Isrc/cc bench/perf_bench.cc quicksort_mm.o -o perf_bench
+//   ./perf_bench [--json FILE] [N [repeat]]
+// ======================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "bench_json.hh"
+#include "bench_util.hh"
+#include "perf_counters.hh"
+#include "quicksort_mm.h"
+#include "quicksort_mm.hh"
+
+namespace {
+  const int nphases = 3;
+  const char *const phase_names[nphases] = {"pivot", "partition", "leaf"};
+
+  bench::perf_counters *counters = nullptr;
+  double phase_total[nphases][bench::perf_counters::nevents + 1];
+}
+
+#ifdef QUICKSORT_MM_PHASE_HOOKS
+namespace {
+  int depth = 0;
+  int outer_phase;
+  double mark[bench::perf_counters::nevents + 1];
+
+  // Counters followed by the time
+  void sample(double *v)
+  {
+    counters->read(v);
+    v[bench::perf_counters::nevents] = bench::now();
+  }
+}
+
+// Charge the outermost phase.
+extern "C" void quicksort_mm_phase_begin(int phase)
+{
+  if (!counters || depth++ > 0) return;
+  outer_phase = phase;
+  sample(mark);
+}
+
+extern "C" void quicksort_mm_phase_end(int)
+{
+  if (!counters || --depth > 0) return;
+  double v[bench::perf_counters::nevents + 1];
+  sample(v);
+  for (int e = 0; e <= bench::perf_counters::nevents; e++) phase_total[outer_phase][e] += v[e] - mark[e];
+}
+#endif
+
+namespace {
+  struct workload {
+    const char *name;
+    void (*run)(std::vector<int> &v);
+  };
+
+  void cc_quicksort(std::vector<int> &v) { quicksort_mm::quicksort(v.begin(), v.end()); }
+  void cc_quickselect(std::vector<int> &v) { quicksort_mm::quickselect(v.begin(), v.begin() + v.size()/2, v.end()); }
+  void c_quicksort(std::vector<int> &v) { quicksort_mm_quicksort(v.data(), v.size(), sizeof(int), bench::cmp_int); }
+  void c_quickselect(std::vector<int> &v) { quicksort_mm_quickselect(v.data(), v.size(), sizeof(int), v.size()/2, bench::cmp_int); }
+
+  void print_row(const char *name, const double *total, size_t nelem, bool have_counters)
+  {
+    std::printf("  %-12s %9.2f", name, total[bench::perf_counters::nevents] * 1e9 / double(nelem));
+    for (int e = 0; e < bench::perf_counters::nevents; e++) {
+      if (have_counters && counters->available(e)) std::printf(" %13.3f", total[e] / double(nelem));
+      else std::printf(" %13s", "n/a");
+    }
+    std::printf("\n");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::string json = bench::json_option(argc, argv);
+  size_t nelem = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  int repeat = argc > 2 ? std::atoi(argv[2]) : 10;
+  if (nelem == 0 || repeat <= 0) {
+    std::fprintf(stderr, "usage: %s [--json FILE] [N [repeat]]\n", argv[0]);
+    return 1;
+  }
+
+  bench::perf_counters pc;
+  counters = &pc;
+  bool have_counters = pc.available();
+  if (!have_counters) std::printf("# counters unavailable (%s); timing only\n", pc.why().c_str());
+
+  static const workload workloads[] = {
+    {"C++ quicksort", cc_quicksort},
+    {"C++ quickselect", cc_quickselect},
+    {"C quicksort", c_quicksort},
+    {"C quickselect", c_quickselect},
+  };
+
+  std::printf("# N = %zu, repeat = %d, values per element\n", nelem, repeat);
+  std::printf("  %-12s %9s", "phase", "ns");
+  for (int e = 0; e < bench::perf_counters::nevents; e++) std::printf(" %13s", bench::perf_counters::name(e));
+  std::printf("\n");
+
+  std::vector<bench::json_result> results;
+  for (auto &w : workloads) {
+    double total[bench::perf_counters::nevents + 1] = {};
+    bench::json_result result = {std::string(w.name) + "/" + std::to_string(nelem), "ns/elem", {}, {}};
+    for (int p = 0; p < nphases; p++) {
+      for (int e = 0; e <= bench::perf_counters::nevents; e++) phase_total[p][e] = 0;
+    }
+
+    for (int r = 0; r < repeat; r++) {
+      auto v = bench::distinct_ints(nelem, uint64_t(r));
+      double t = bench::now();
+      pc.start();
+      w.run(v);
+      pc.stop();
+      t = bench::now() - t;
+
+      double c[bench::perf_counters::nevents + 1];
+      pc.read(c);
+      c[bench::perf_counters::nevents] = t;
+      for (int e = 0; e <= bench::perf_counters::nevents; e++) total[e] += c[e];
+      result.samples.push_back(t * 1e9 / double(nelem));
+      bench::do_not_optimize(v);
+    }
+
+    size_t count = nelem * size_t(repeat);
+    std::printf("%s\n", w.name);
+    print_row("total", total, count, have_counters);
+    for (int e = 0; e < bench::perf_counters::nevents; e++) {
+      if (have_counters && pc.available(e)) result.extra.emplace_back(bench::perf_counters::name(e), total[e] / double(count));
+    }
+#ifdef QUICKSORT_MM_PHASE_HOOKS
+    double rest[bench::perf_counters::nevents + 1];
+    for (int e = 0; e <= bench::perf_counters::nevents; e++) rest[e] = total[e];
+    for (int p = 0; p < nphases; p++) {
+      print_row(phase_names[p], phase_total[p], count, have_counters);
+      result.extra.emplace_back(std::string(phase_names[p]) + ".ns", phase_total[p][bench::perf_counters::nevents] * 1e9 / double(count));
+      for (int e = 0; e <= bench::perf_counters::nevents; e++) rest[e] -= phase_total[p][e];
+    }
+    print_row("rest", rest, count, have_counters);
+#else
+    (void)phase_names;
+#endif
+    results.push_back(result);
+  }
+
+  if (!json.empty() && !bench::write_json(json, "perf_bench", results)) {
+    std::fprintf(stderr, "cannot write %s\n", json.c_str());
+    return 1;
+  }
+  return 0;
+}
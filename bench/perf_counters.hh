@@ -0,0 +1,162 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Hardware performance counters by perf_event_open (Linux).
+//
+// The events are opened as a group, so that they are counted over the
+// same instructions; the counts are scaled by enabled/running time
+// when the group is multiplexed. Only the user space is counted.
+//
+// Counters are often unavailable, e.g. in containers or with
+// kernel.perf_event_paranoid > 2, and on the other systems; then
+// available() is false (why() tells the reason) and the events which
+// cannot be opened are skipped.
+// ======================================================
+
+#ifndef QUICKSORT_MM_PERF_COUNTERS_HH_INCLUDED
+#define QUICKSORT_MM_PERF_COUNTERS_HH_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+  class perf_counters {
+  public:
+    enum event { cycles, instructions, branch_misses, l1d_misses, llc_misses, dtlb_misses, nevents };
+
+    static const char *name(int e)
+    {
+      static const char *const names[nevents] = {
+        "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses", "dTLB-misses"
+      };
+      return names[e];
+    }
+
+    perf_counters() : leader_(-1)
+    {
+      for (int e = 0; e < nevents; e++) fd_[e] = -1;
+#if defined(__linux__)
+      static const uint32_t types[nevents] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE
+      };
+      static const uint64_t configs[nevents] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        cache_event(PERF_COUNT_HW_CACHE_L1D),
+        cache_event(PERF_COUNT_HW_CACHE_LL),
+        cache_event(PERF_COUNT_HW_CACHE_DTLB)
+      };
+      for (int e = 0; e < nevents; e++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = types[e];
+        attr.config = configs[e];
+        attr.disabled = leader_ < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+          | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0));
+        if (fd < 0) {
+          if (why_.empty()) why_ = std::string(name(e)) + ": " + std::strerror(errno);
+          continue;
+        }
+        if (leader_ < 0) leader_ = fd;
+        fd_[e] = fd;
+        ioctl(fd, PERF_EVENT_IOC_ID, &id_[e]);
+      }
+#else
+      why_ = "perf_event_open is not supported on this system";
+#endif
+    }
+
+    ~perf_counters()
+    {
+#if defined(__linux__)
+      for (int e = 0; e < nevents; e++) {
+        if (fd_[e] >= 0) close(fd_[e]);
+      }
+#endif
+    }
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+
+    bool available() const { return leader_ >= 0; }
+    bool available(int e) const { return fd_[e] >= 0; }
+    const std::string &why() const { return why_; }
+
+    void start()
+    {
+#if defined(__linux__)
+      if (leader_ < 0) return;
+      ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    void stop()
+    {
+#if defined(__linux__)
+      if (leader_ < 0) return;
+      ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Read the counts since start() into v[nevents]; the unavailable ones are 0.
+    // It can be called while counting. It returns false if nothing was counted.
+    bool read(double *v) const
+    {
+      for (int e = 0; e < nevents; e++) v[e] = 0;
+#if defined(__linux__)
+      if (leader_ < 0) return false;
+      struct {
+        uint64_t nr, enabled, running;
+        struct { uint64_t value, id; } values[nevents];
+      } buf;
+      if (::read(leader_, &buf, sizeof buf) <= 0 || buf.running == 0) return false;
+      double scale = double(buf.enabled) / double(buf.running);
+      for (uint64_t i = 0; i < buf.nr && i < uint64_t(nevents); i++) {
+        for (int e = 0; e < nevents; e++) {
+          if (fd_[e] >= 0 && id_[e] == buf.values[i].id) v[e] = double(buf.values[i].value) * scale;
+        }
+      }
+      return true;
+#else
+      return false;
+#endif
+    }
+
+  private:
+#if defined(__linux__)
+    static uint64_t cache_event(uint64_t cache)
+    {
+      return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+    }
+#endif
+
+    int leader_;
+    int fd_[nevents];
+    uint64_t id_[nevents];
+    std::string why_;
+  };
+}
+
+#endif
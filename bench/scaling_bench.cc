@@ -0,0 +1,206 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Thread scaling and memory bandwidth of the parallel sort.
+//
+// For each N and each number of threads P (1, 2, 4, ..., all cores),
+// the following are measured on 32bits-integers:
+// * copy, triad: STREAM-like baselines, a[i] = b[i] and
+//                a[i] = b[i] + 3 c[i], split into P slices;
+// * partition:   P concurrent partitions of P slices, as the tasks of
+//                async_sort at the depth log2 P;
+// * leaf:        the sorts of the subranges of parallel_task_size/2
+//                elements, P slices of them;
+// * sort:        quicksort_mm::async_sort of the whole array.
+// GB/s counts the bytes of the input once per pass (copy: read and
+// write, triad: 2 reads and a write). The speedup and the efficiency
+// are against P = 1, and %copy is the bandwidth over that of copy with
+// the same P: partition close to 100% is bound by the memory.
+//
+// The sizes which need more than half of the physical memory are
+// skipped. The C async sort runs on a pool of a fixed size, so that
+// only the C++ version is swept.
+//
+//   c++ -std=c++11 -O3 -DNDEBUG -Isrc/cc bench/scaling_bench.cc -o scaling_bench -lpthread
+//   ./scaling_bench [--json FILE] [repeat [N...]]
+// ======================================================
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_json.hh"
+#include "bench_util.hh"
+#include "quicksort_mm.hh"
+#include "quicksort_mm_async.hh"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+  // Run f(i) for i = 0, ..., P-1 on the pool and wait for them.
+  void parallel_for(quicksort_mm::thread_pool &pool, unsigned P, const std::function<void(unsigned)> &f)
+  {
+    std::vector<std::future<void> > done;
+    for (unsigned i = 0; i < P; i++) {
+      auto task = std::make_shared<std::packaged_task<void()> >([&f, i] { f(i); });
+      done.push_back(task->get_future());
+      pool.submit([task] { (*task)(); });
+    }
+    for (auto &d : done) d.get();
+  }
+
+  size_t physical_memory()
+  {
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    long pages = sysconf(_SC_PHYS_PAGES), page = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page > 0) return size_t(pages) * size_t(page);
+#endif
+    return size_t(4) << 30;
+  }
+
+  struct phase_result {
+    const char *phase;
+    double bytes;                // per pass
+    std::vector<double> seconds;
+  };
+
+  double best(const std::vector<double> &v)
+  {
+    double m = v[0];
+    for (double x : v) m = x < m ? x : m;
+    return m;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::string json = bench::json_option(argc, argv);
+  int repeat = argc > 1 ? std::atoi(argv[1]) : 3;
+  std::vector<size_t> sizes;
+  for (int i = 2; i < argc; i++) sizes.push_back(size_t(std::strtod(argv[i], nullptr)));
+  if (sizes.empty()) sizes = {size_t(1e6), size_t(1e7), size_t(1e8)};
+  if (repeat <= 0) {
+    std::fprintf(stderr, "usage: %s [--json FILE] [repeat [N...]]\n", argv[0]);
+    return 1;
+  }
+
+  unsigned cores = std::thread::hardware_concurrency();
+  if (cores == 0) cores = 1;
+  std::vector<unsigned> threads;
+  for (unsigned p = 1; p < cores; p *= 2) threads.push_back(p);
+  threads.push_back(cores);
+
+  std::vector<bench::json_result> results;
+  std::printf("%12s %4s %-9s %10s %8s %8s %6s %6s\n", "N", "P", "phase", "seconds", "GB/s", "speedup", "eff", "%copy");
+
+  for (size_t n : sizes) {
+    // The sort array, its input, and the STREAM arrays
+    if (5 * n * sizeof(uint32_t) > physical_memory() / 2) {
+      std::printf("# N = %zu skipped: not enough memory\n", n);
+      continue;
+    }
+    auto input = bench::distinct_ints(n, 1);
+    std::vector<int> v(n);
+    std::vector<uint32_t> a(n), b(n, 1), c(n, 2);
+    double base[5] = {};
+
+    // The leaves of async_sort are shorter than parallel_task_size.
+    const size_t leaf = quicksort_mm::parallel_task_size / 2;
+
+    for (unsigned P : threads) {
+      quicksort_mm::thread_pool pool(P);
+      auto slice = [n, P](unsigned i, size_t &lo, size_t &hi) {
+        lo = n * i / P;
+        hi = n * (i+1) / P;
+      };
+
+      phase_result phases[5] = {
+        {"copy", 2.0 * double(n) * 4, {}},
+        {"triad", 3.0 * double(n) * 4, {}},
+        {"partition", double(n) * 4, {}},
+        {"leaf", double(n) * 4, {}},
+        {"sort", double(n) * 4, {}},
+      };
+
+      for (int r = 0; r < repeat; r++) {
+        double t = bench::now();
+        parallel_for(pool, P, [&](unsigned i) {
+          size_t lo, hi;
+          slice(i, lo, hi);
+          for (size_t j = lo; j < hi; j++) a[j] = b[j];
+        });
+        phases[0].seconds.push_back(bench::now() - t);
+        bench::do_not_optimize(a);
+
+        t = bench::now();
+        parallel_for(pool, P, [&](unsigned i) {
+          size_t lo, hi;
+          slice(i, lo, hi);
+          for (size_t j = lo; j < hi; j++) a[j] = b[j] + 3*c[j];
+        });
+        phases[1].seconds.push_back(bench::now() - t);
+        bench::do_not_optimize(a);
+
+        v = input;
+        t = bench::now();
+        parallel_for(pool, P, [&](unsigned i) {
+          size_t lo, hi;
+          slice(i, lo, hi);
+          if (hi - lo > 1) quicksort_mm::partition(v.begin() + lo, v.begin() + hi, v.begin() + (lo+hi)/2, std::less<int>());
+        });
+        phases[2].seconds.push_back(bench::now() - t);
+
+        v = input;
+        t = bench::now();
+        parallel_for(pool, P, [&](unsigned i) {
+          size_t lo, hi;
+          slice(i, lo, hi);
+          for (size_t j = lo; j < hi; j += leaf) {
+            size_t end = hi - j < leaf ? hi : j + leaf;
+            quicksort_mm::quicksort(v.begin() + j, v.begin() + end);
+          }
+        });
+        phases[3].seconds.push_back(bench::now() - t);
+
+        v = input;
+        t = bench::now();
+        quicksort_mm::async_sort(v.begin(), v.end(), std::less<int>(), pool).get();
+        phases[4].seconds.push_back(bench::now() - t);
+      }
+
+      for (int k = 0; k < 5; k++) {
+        double s = best(phases[k].seconds);
+        if (P == 1) base[k] = s;
+        double gbs = phases[k].bytes / s * 1e-9;
+        double copy = phases[0].bytes / best(phases[0].seconds) * 1e-9;
+        double speedup = base[k] / s;
+        std::printf("%12zu %4u %-9s %10.4f %8.2f %8.2f %6.2f %5.0f%%\n",
+                    n, P, phases[k].phase, s, gbs, speedup, speedup / P, gbs / copy * 100);
+
+        bench::json_result jr = {std::string(phases[k].phase) + "/" + std::to_string(n) + "/" + std::to_string(P),
+                                 "s", phases[k].seconds, {}};
+        jr.extra.emplace_back("GB/s", gbs);
+        jr.extra.emplace_back("efficiency", speedup / P);
+        results.push_back(jr);
+      }
+    }
+  }
+
+  if (!json.empty() && !bench::write_json(json, "scaling_bench", results)) {
+    std::fprintf(stderr, "cannot write %s\n", json.c_str());
+    return 1;
+  }
+  return 0;
+}
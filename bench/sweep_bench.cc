@@ -0,0 +1,204 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Element-size and comparator-cost sweep of the C version.
+//
+// quicksort_mm_quicksort is run for the element sizes 1 B to 1 KiB and
+// the comparators
+// * trivial:   compares the key, the last min(size, 4) bytes;
+// * memcmp:    memcmp of the whole element (the bytes before the key
+//              are equal, so that all the bytes are read);
+// * expensive: trivial plus about 200 dependent operations.
+// The "indirect" mode sorts the pointers to the elements and then
+// gathers the elements into a new array; qsort is shown for reference.
+//
+// The time, the comparisons and the bytes moved by the swaps
+// (quicksort_mm_swap_bytes, plus the gather for "indirect") are
+// reported per element. N is reduced so that the array is at most
+// 64 MiB.
+//
+//   cc -std=c99 -O3 -DNDEBUG -DQUICKSORT_MM_COUNT_SWAPS -c src/c/quicksort_mm.c
+//   c++ -std=c++11 -O3 -DNDEBUG -DQUICKSORT_MM_COUNT_SWAPS -Isrc/c -Isrc/cc bench/sweep_bench.cc quicksort_mm.o -o sweep_bench
+//   ./sweep_bench [--json FILE] [N [repeat]]
+// ======================================================
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bench_json.hh"
+#include "bench_util.hh"
+#include "quicksort_mm.h"
+#include "quicksort_mm.hh"
+
+namespace {
+  const size_t max_bytes = size_t(64) << 20;
+
+  // The comparators have no context; these are set per run.
+  size_t elem_size;
+  size_t key_width;
+  uint64_t comparisons;
+  int (*base_cmp)(const void *, const void *);
+
+  inline uint32_t key_of(const void *p)
+  {
+    const unsigned char *k = (const unsigned char *)p + elem_size - key_width;
+    uint32_t x = 0;
+    for (size_t i = 0; i < key_width; i++) x = (x << 8) | k[i];
+    return x;
+  }
+
+  int cmp_trivial(const void *a, const void *b)
+  {
+    comparisons++;
+    uint32_t x = key_of(a), y = key_of(b);
+    return (x > y) - (x < y);
+  }
+
+  int cmp_memcmp(const void *a, const void *b)
+  {
+    comparisons++;
+    return std::memcmp(a, b, elem_size);
+  }
+
+  volatile uint64_t expensive_sink;
+
+  int cmp_expensive(const void *a, const void *b)
+  {
+    comparisons++;
+    uint32_t x = key_of(a), y = key_of(b);
+    uint64_t h = x ^ (uint64_t(y) << 32);
+    for (int i = 0; i < 32; i++) {
+      h ^= h << 13;
+      h ^= h >> 7;
+      h ^= h << 17;
+    }
+    expensive_sink = h;
+    return (x > y) - (x < y);
+  }
+
+  // For the indirect mode: an element of pointers
+  int cmp_indirect(const void *a, const void *b)
+  {
+    return base_cmp(*(const char *const *)a, *(const char *const *)b);
+  }
+
+  struct comparator_kind {
+    const char *name;
+    int (*cmp)(const void *, const void *);
+  };
+
+  // Elements with the distinct (up to the key width) keys in random order
+  std::vector<unsigned char> make_elements(size_t n, size_t sz, uint64_t seed)
+  {
+    std::vector<unsigned char> v(n*sz, 0x5a);
+    auto keys = bench::distinct_ints(n, seed);
+    size_t w = sz < 4 ? sz : 4;
+    for (size_t i = 0; i < n; i++) {
+      uint32_t k = uint32_t(keys[i]);
+      unsigned char *p = &v[i*sz + sz - w];
+      for (size_t j = 0; j < w; j++) p[j] = (unsigned char)(k >> (8*(w-1-j)));
+    }
+    return v;
+  }
+
+  bool is_sorted(const unsigned char *p, size_t n, size_t sz)
+  {
+    for (size_t i = 1; i < n; i++) {
+      uint32_t x = key_of(p + (i-1)*sz), y = key_of(p + i*sz);
+      if (y < x) return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::string json = bench::json_option(argc, argv);
+  size_t max_n = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+  int repeat = argc > 2 ? std::atoi(argv[2]) : 5;
+  if (max_n == 0 || repeat <= 0) {
+    std::fprintf(stderr, "usage: %s [--json FILE] [N [repeat]]\n", argv[0]);
+    return 1;
+  }
+
+  static const comparator_kind kinds[] = {
+    {"trivial", cmp_trivial},
+    {"memcmp", cmp_memcmp},
+    {"expensive", cmp_expensive},
+  };
+  static const char *const modes[] = {"direct", "indirect", "qsort"};
+
+  std::vector<bench::json_result> results;
+  std::printf("%-9s %-9s %6s %8s %10s %10s %12s\n", "mode", "cmp", "size", "N", "ns/elem", "cmp/elem", "swapB/elem");
+  for (size_t sz = 1; sz <= 1024; sz *= 2) {
+    size_t n = max_bytes / sz < max_n ? max_bytes / sz : max_n;
+    elem_size = sz;
+    key_width = sz < 4 ? sz : 4;
+
+    for (auto &kind : kinds) {
+      for (const char *mode : modes) {
+        bench::json_result result = {std::string(mode) + "/" + kind.name + "/" + std::to_string(sz), "ns/elem", {}, {}};
+        double cmps = 0, bytes = 0;
+        for (int r = 0; r < repeat; r++) {
+          auto v = make_elements(n, sz, uint64_t(r));
+          comparisons = 0;
+          quicksort_mm_swap_bytes = 0;
+          double t = bench::now();
+
+          if (std::strcmp(mode, "direct") == 0) {
+            quicksort_mm_quicksort(v.data(), n, sz, kind.cmp);
+          }
+          else if (std::strcmp(mode, "qsort") == 0) {
+            std::qsort(v.data(), n, sz, kind.cmp);
+          }
+          else {
+            std::vector<const unsigned char *> ptr(n);
+            for (size_t i = 0; i < n; i++) ptr[i] = &v[i*sz];
+            base_cmp = kind.cmp;
+            quicksort_mm_quicksort(ptr.data(), n, sizeof ptr[0], cmp_indirect);
+            std::vector<unsigned char> out(n*sz);
+            for (size_t i = 0; i < n; i++) std::memcpy(&out[i*sz], ptr[i], sz);
+            v.swap(out);
+            quicksort_mm_swap_bytes += n*sz;  // the gather
+          }
+
+          t = bench::now() - t;
+          result.samples.push_back(t * 1e9 / double(n));
+          cmps += double(comparisons);
+          bytes += double(quicksort_mm_swap_bytes);
+          if (!is_sorted(v.data(), n, sz)) {
+            std::fprintf(stderr, "not sorted: %s\n", result.name.c_str());
+            return 1;
+          }
+        }
+
+        cmps /= double(n) * repeat;
+        bytes /= double(n) * repeat;
+        bool has_bytes = std::strcmp(mode, "qsort") != 0;
+        std::vector<double> sorted = result.samples;
+        quicksort_mm::quicksort(sorted.begin(), sorted.end());
+        std::printf("%-9s %-9s %6zu %8zu %10.2f %10.2f", mode, kind.name, sz, n, sorted[sorted.size()/2], cmps);
+        if (has_bytes) std::printf(" %12.1f\n", bytes);
+        else std::printf(" %12s\n", "n/a");
+
+        result.extra.emplace_back("comparisons", cmps);
+        if (has_bytes) result.extra.emplace_back("swap_bytes", bytes);
+        results.push_back(result);
+      }
+    }
+  }
+
+  if (!json.empty() && !bench::write_json(json, "sweep_bench", results)) {
+    std::fprintf(stderr, "cannot write %s\n", json.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -23,12 +23,101 @@
 
 
 
+// clock_gettime() of the latency statistics
+#if defined(QUICKSORT_MM_STATS) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include "quicksort_mm.h"
 
 typedef int (*comparator)(const void *, const void *);
 
+// Cancellation token
+// func(arg) returns non-zero when the routine should stop.
+// It is checked once per partition of CANCEL_CHECK_SIZE or more elements,
+// and the cancellation is sticky.
+typedef struct {
+  int (*func)(void *);
+  void *arg;
+  int cancelled;
+} cancel_token;
+
+#define CANCEL_CHECK_SIZE 1024
+
+// Subarrays shorter than these are sorted by small_sort() in quicksort
+// and quickselect, respectively, as in the C++ version.
+// They may be tuned by -D; a cutoff must be 3 or more.
+#ifndef QUICKSORT_MM_SORT_CUTOFF
+#define QUICKSORT_MM_SORT_CUTOFF 16
+#endif
+#ifndef QUICKSORT_MM_SELECT_CUTOFF
+#define QUICKSORT_MM_SELECT_CUTOFF 7
+#endif
+#if QUICKSORT_MM_SORT_CUTOFF < 3 || QUICKSORT_MM_SELECT_CUTOFF < 3
+#error "QUICKSORT_MM_SORT_CUTOFF and QUICKSORT_MM_SELECT_CUTOFF must be 3 or more"
+#endif
+
+// Elements up to this size are moved through a buffer by small_sort().
+#define SMALL_SORT_BUFFER 256
+
+// The buffer is passed to the comparator, so it is aligned as malloc().
+typedef union {
+  char c[SMALL_SORT_BUFFER];
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+  max_align_t a;
+#else
+  long double d;
+  void *p;
+  long long l;
+#endif
+} small_sort_buffer;
+
+// Phase hooks for profiling (see quicksort_mm.h)
+#ifdef QUICKSORT_MM_PHASE_HOOKS
+#define PHASE_BEGIN(phase) quicksort_mm_phase_begin(phase)
+#define PHASE_END(phase) quicksort_mm_phase_end(phase)
+#else
+#define PHASE_BEGIN(phase) ((void)0)
+#define PHASE_END(phase) ((void)0)
+#endif
+
+// USDT probes of the provider quicksort_mm (see quicksort_mm.h)
+#if defined(QUICKSORT_MM_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROBE2(name, a, b) DTRACE_PROBE2(quicksort_mm, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(quicksort_mm, name, a, b, c)
+#endif
+#endif
+#ifndef PROBE2
+#define PROBE2(name, a, b) ((void)0)
+#define PROBE3(name, a, b, c) ((void)0)
+#endif
+
+// Latency histograms of the calls (see the end of this file)
+#ifdef QUICKSORT_MM_STATS
+static uint64_t stats_now(void);
+static void stats_record(int op, size_t n, size_t sz, uint64_t begin);
+#define STATS_BEGIN(t) uint64_t t = stats_now()
+#define STATS_END(op, t, n, sz) stats_record(op, n, sz, t)
+#else
+#define STATS_BEGIN(t) ((void)0)
+#define STATS_END(op, t, n, sz) ((void)0)
+#endif
+
+// Bytes moved by swap() and small_sort(), for the benchmarks (not thread-safe)
+#ifdef QUICKSORT_MM_COUNT_SWAPS
+size_t quicksort_mm_swap_bytes;
+#define COUNT_BYTES(bytes) (quicksort_mm_swap_bytes += (bytes))
+#else
+#define COUNT_BYTES(bytes) ((void)0)
+#endif
+#define COUNT_SWAP(sz) COUNT_BYTES(2*(sz))
+
 
 // ======================================================
 // Utilities
@@ -39,6 +128,7 @@ typedef int (*comparator)(const void *, const void *);
 // This routine is not efficient. We take simplicity.
 static void swap(char *p, char *q, size_t sz)
 {
+  COUNT_SWAP(sz);
   while (sz > 0) {
     char tmp = *p;
     *p = *q;
@@ -66,6 +156,57 @@ static void swap_ptr(char **p, char **q)
 }
 
 
+// Sort a short array (the leaves of quicksort and quickselect).
+// 2 to 4 elements are sorted by the optimal sorting networks, and the
+// longer ones by insertion sort, which keeps the element to insert in
+// a buffer and shifts the greater ones at once.
+static void small_sort(char *p, size_t n, size_t sz, comparator cmp)
+{
+#define CMP_SWAP(i, j) do { if (cmp(p+(i)*sz, p+(j)*sz) > 0) swap(p+(i)*sz, p+(j)*sz, sz); } while (0)
+  switch (n) {
+  case 0:
+  case 1:
+    return;
+  case 2:
+    CMP_SWAP(0, 1);
+    return;
+  case 3:
+    CMP_SWAP(0, 1);
+    CMP_SWAP(1, 2);
+    CMP_SWAP(0, 1);
+    return;
+  case 4:
+    CMP_SWAP(0, 1);
+    CMP_SWAP(2, 3);
+    CMP_SWAP(0, 2);
+    CMP_SWAP(1, 3);
+    CMP_SWAP(1, 2);
+    return;
+  }
+#undef CMP_SWAP
+
+  char *end = p + n*sz;
+  if (sz > SMALL_SORT_BUFFER) {
+    for (char *q = p+sz; q < end; q += sz) {
+      for (char *r = q; r > p && cmp(r-sz, r) > 0; r -= sz) swap(r-sz, r, sz);
+    }
+    return;
+  }
+
+  small_sort_buffer buf;
+  char *tmp = buf.c;
+  for (char *q = p+sz; q < end; q += sz) {
+    if (cmp(q-sz, q) <= 0) continue;
+    memcpy(tmp, q, sz);
+    char *r = q-sz;
+    while (r > p && cmp(r-sz, tmp) > 0) r -= sz;
+    memmove(r+sz, r, (size_t)(q-r));
+    memcpy(r, tmp, sz);
+    COUNT_BYTES((size_t)(q-r) + 2*sz);
+  }
+}
+
+
 
 
 // Get the median of given five elements.
@@ -98,15 +239,26 @@ static inline char *median3(char *p, char *q, char *r, comparator cmp)
 }
 
 
+// Check the cancellation token (may be null) for a subarray of size n.
+// A null callback never cancels.
+static int is_cancelled(cancel_token *token, size_t n)
+{
+  if (!token || !token->func || n < CANCEL_CHECK_SIZE) return 0;
+  if (!token->cancelled && token->func(token->arg)) token->cancelled = 1;
+  return token->cancelled;
+}
+
+
 // approximate square root
+// 1 for n < 4 (including 0)
 static inline size_t approx_sqrt(size_t n)
 {
-  int base = -1;
-  while (0 < n) {
+  int base = 0;
+  while (4 <= n) {
     base += 1;
     n /= 4;
   }
-  return 1 << base;
+  return (size_t)1 << base;
 }
 
 
@@ -158,13 +310,70 @@ PARTITION_END:;
 }
 
 
+// 3-way partition (Dijkstra)
+// [begin, lo) < pivot, [lo, hi) == pivot, [hi, end) > pivot.
+// The pivot stays at begin during the loop, and is moved to the
+// equal block at the end. lo is returned and hi is set to *hi_out.
+static char *partition3(char *begin, char *pivot, size_t n, size_t sz, comparator cmp, char **hi_out)
+{
+  char *lo = begin + sz;
+  char *cur = begin + sz;
+  char *hi = begin + sz * n;
+
+  assert((pivot-begin) % sz == 0);
+  assert((pivot-begin) / sz < n);
+
+  swap_unless_same(pivot, begin, sz);
+  pivot = begin;
+
+  while (cur < hi) {
+    int c = cmp(cur, pivot);
+    if (c < 0) {
+      swap_unless_same(lo, cur, sz);
+      lo += sz;
+      cur += sz;
+    }
+    else if (c > 0) {
+      hi -= sz;
+      swap_unless_same(cur, hi, sz);
+    }
+    else {
+      cur += sz;
+    }
+  }
+  lo -= sz;
+  swap_unless_same(pivot, lo, sz);
+
+  *hi_out = hi;
+  return lo;
+}
+
+
 
 // ======================================================
 // Median of Medians
 // ======================================================
 
 static char *rs3_5_2_pick_pivot(char *p, size_t n, size_t sz, size_t thin, comparator cmp);
-static char *rs3_5_2_find_kth(char *p, size_t n, size_t sz, size_t thin, size_t kth, comparator cmp);
+static char *rs3_5_2_find_kth(char *p, size_t n, size_t sz, size_t thin, size_t kth, comparator cmp, cancel_token *token);
+
+// The group loop of rs3_5_2_pick_pivot
+// The pseudo-median of the i-th group of 15 elements (7 from p0, 1 from q0
+// and 7 from r0) is moved to q0+i*sz.
+static void rs3_5_2_gather_medians(char *p0, char *q0, char *r0, size_t nnext, size_t sz, comparator cmp)
+{
+  for (size_t i = 0; i < nnext; i++) {
+    // median of 5 (median of 3)
+    char *s0 = median3(p0+(i*7+0)*sz, p0+(i*7+1)*sz, p0+(i*7+2)*sz, cmp);
+    char *s1 = median3(p0+(i*7+3)*sz, p0+(i*7+4)*sz, p0+(i*7+5)*sz, cmp);
+    char *s2 = median3(p0+(i*7+6)*sz, q0+(i*1+0)*sz, r0+(i*7+0)*sz, cmp);
+    char *s3 = median3(r0+(i*7+1)*sz, r0+(i*7+2)*sz, r0+(i*7+3)*sz, cmp);
+    char *s4 = median3(r0+(i*7+4)*sz, r0+(i*7+5)*sz, r0+(i*7+6)*sz, cmp);
+
+    swap_unless_same(q0+i*sz, median5(s0,s1,s2,s3,s4,cmp), sz);
+  }
+}
+
 
 // A variant of the repeated step algorithm (3-5).
 // 3-3 and 4-4 are presented in the original paper.
@@ -180,39 +389,39 @@ static char *rs3_5_2_pick_pivot(char *p, size_t n, size_t sz, size_t thin, compa
   char *q0 = p + 7*(n/15)*sz;
   char *r0 = p + (n-nnext*7)*sz;
 
-  for (size_t i = 0; i < nnext; i++) {
-    // median of 5 (median of 3)
-    char *s0 = median3(p0+(i*7+0)*sz, p0+(i*7+1)*sz, p0+(i*7+2)*sz, cmp);
-    char *s1 = median3(p0+(i*7+3)*sz, p0+(i*7+4)*sz, p0+(i*7+5)*sz, cmp);
-    char *s2 = median3(p0+(i*7+6)*sz, q0+(i*1+0)*sz, r0+(i*7+0)*sz, cmp);
-    char *s3 = median3(r0+(i*7+1)*sz, r0+(i*7+2)*sz, r0+(i*7+3)*sz, cmp);
-    char *s4 = median3(r0+(i*7+4)*sz, r0+(i*7+5)*sz, r0+(i*7+6)*sz, cmp);
-
-    swap_unless_same(q0+i*sz, median5(s0,s1,s2,s3,s4,cmp), sz);
-  }
+  rs3_5_2_gather_medians(p0, q0, r0, nnext, sz, cmp);
 
   // Get the median of (pseudo-) medians 
-  return rs3_5_2_find_kth(q0, nnext, sz, 2, nnext/2, cmp);
+  return rs3_5_2_find_kth(q0, nnext, sz, 2, nnext/2, cmp, NULL);
 }
 
 
-static char *rs3_5_2_find_kth(char *p, size_t n, size_t sz, size_t thin, size_t kth, comparator cmp)
+// When cancelled, p+kth*sz is returned without the k-th element.
+static char *rs3_5_2_find_kth(char *p, size_t n, size_t sz, size_t thin, size_t kth, comparator cmp, cancel_token *token)
 {
   assert(kth < n);
 
-  if (n == 1) return p;
-  if (n == 2) {
-    if (cmp(p, p+sz) > 0) swap(p, p+sz, sz);
+  if (n < QUICKSORT_MM_SELECT_CUTOFF) {
+    PHASE_BEGIN(QUICKSORT_MM_PHASE_LEAF);
+    small_sort(p, n, sz, cmp);
+    PHASE_END(QUICKSORT_MM_PHASE_LEAF);
     return p+kth*sz;
   }
+  if (is_cancelled(token, n)) return p+kth*sz;
 
+  PHASE_BEGIN(QUICKSORT_MM_PHASE_PIVOT);
   char *pivot = rs3_5_2_pick_pivot(p, n, sz, thin, cmp);
+  PHASE_END(QUICKSORT_MM_PHASE_PIVOT);
+  PROBE3(pivot, p, n, (size_t)(pivot - p) / sz);
 
   assert(p <= pivot);
   assert((pivot - p) % sz == 0);
   assert((pivot - p) / sz < n);
   
+  PHASE_BEGIN(QUICKSORT_MM_PHASE_PARTITION);
   char *pivotx = partition(p, pivot, n, sz, cmp);
+  PHASE_END(QUICKSORT_MM_PHASE_PARTITION);
+  PROBE3(partition, p, n, (size_t)(pivotx - p) / sz);
 
   assert((pivotx - p) % sz == 0);
   assert((pivotx - p) / sz < n);
@@ -224,10 +433,10 @@ static char *rs3_5_2_find_kth(char *p, size_t n, size_t sz, size_t thin, size_t
 
   // Recursive application
   if (nl < kth) {
-    return rs3_5_2_find_kth(pivotx + sz, nr, sz, 2, kth-nl-1, cmp);
+    return rs3_5_2_find_kth(pivotx + sz, nr, sz, 2, kth-nl-1, cmp, token);
   }
   else if (kth < nl) {
-    return rs3_5_2_find_kth(p, nl, sz, 2, kth, cmp);
+    return rs3_5_2_find_kth(p, nl, sz, 2, kth, cmp, token);
   }
   else {
     return pivotx;
@@ -243,7 +452,7 @@ static char *rs3_5_2_find_kth(char *p, size_t n, size_t sz, size_t thin, size_t
 // Main routine of quick sort
 // ======================================================
 
-static void quicksort_body(char *begin, char *end, size_t sz, comparator cmp, size_t thin)
+static void quicksort_body(char *begin, char *end, size_t sz, comparator cmp, size_t thin, cancel_token *token)
 {
   assert(begin <= end);
   assert(sz > 0);
@@ -255,30 +464,34 @@ static void quicksort_body(char *begin, char *end, size_t sz, comparator cmp, si
   size_t n = (size_t)(end - begin) / sz;
 
   // Boundary condition
-  if (n <= 1) {
-    return;
-  }
-  if (n == 2) {
-    if (cmp(begin, begin+sz) > 0) {
-      swap(begin, begin+sz, sz);
-    }
+  if (n < QUICKSORT_MM_SORT_CUTOFF) {
+    PHASE_BEGIN(QUICKSORT_MM_PHASE_LEAF);
+    small_sort(begin, n, sz, cmp);
+    PHASE_END(QUICKSORT_MM_PHASE_LEAF);
     return;
   }
+  if (is_cancelled(token, n)) return;
 
   // Partition
+  PHASE_BEGIN(QUICKSORT_MM_PHASE_PIVOT);
   char *pivot = rs3_5_2_pick_pivot(begin, n, sz, thin, cmp);
+  PHASE_END(QUICKSORT_MM_PHASE_PIVOT);
+  PROBE3(pivot, begin, n, (size_t)(pivot - begin) / sz);
+  PHASE_BEGIN(QUICKSORT_MM_PHASE_PARTITION);
   char *pivot_pos = partition(begin, pivot, n, sz, cmp);
+  PHASE_END(QUICKSORT_MM_PHASE_PARTITION);
+  PROBE3(partition, begin, n, (size_t)(pivot_pos - begin) / sz);
 
   // Recursive application
   // The tail call optimization is assumed
   // 12/17 ~ 0.7059 is an approximate value of sqrt(1/2)
   if (end-pivot_pos < pivot_pos-begin) {
-    quicksort_body(pivot_pos+sz, end, sz, cmp, thin*12/17);
-    quicksort_body(begin, pivot_pos, sz, cmp, thin*12/17);
+    quicksort_body(pivot_pos+sz, end, sz, cmp, thin*12/17, token);
+    quicksort_body(begin, pivot_pos, sz, cmp, thin*12/17, token);
   }
   else {
-    quicksort_body(begin, pivot_pos, sz, cmp, thin*12/17);
-    quicksort_body(pivot_pos+sz, end, sz, cmp, thin*12/17);
+    quicksort_body(begin, pivot_pos, sz, cmp, thin*12/17, token);
+    quicksort_body(pivot_pos+sz, end, sz, cmp, thin*12/17, token);
   }
 }
 
@@ -301,7 +514,33 @@ void quicksort_mm_quicksort(void *p, size_t n, size_t sz, comparator cmp)
   char *end = begin + n*sz;
 
   if (end < begin) return; // In this case the routine does not work.
-  quicksort_body(begin, end, sz, cmp, approx_sqrt(n));
+  PROBE3(quicksort__entry, p, n, sz);
+  STATS_BEGIN(t);
+  quicksort_body(begin, end, sz, cmp, approx_sqrt(n), NULL);
+  STATS_END(QUICKSORT_MM_STATS_QUICKSORT, t, n, sz);
+  PROBE2(quicksort__return, p, n);
+}
+
+
+// Quicksort with a cancellation callback.
+// It returns 0 if the sort is completed. When cancel(arg) returns
+// non-zero, 1 is returned and the array is split into blocks, each of
+// which is either sorted or not, such that no element is greater than
+// an element of a later block. A null cancel never cancels.
+int quicksort_mm_quicksort_cancellable(void *p, size_t n, size_t sz, comparator cmp, int (*cancel)(void *), void *arg)
+{
+  if (!p) return 0;
+  if (n == 0) return 0;
+  if (sz == 0) return 0;
+
+  char *begin = (char *)p;
+  char *end = begin + n*sz;
+
+  if (end < begin) return 0; // In this case the routine does not work.
+
+  cancel_token token = {cancel, arg, 0};
+  quicksort_body(begin, end, sz, cmp, approx_sqrt(n), &token);
+  return token.cancelled;
 }
 
 
@@ -324,5 +563,672 @@ void quicksort_mm_quickselect(void *p, size_t n, size_t sz, size_t kth, comparat
   char *end = begin + n*sz;
 
   if (end < begin) return; // In this case the routine does not work.
-  rs3_5_2_find_kth(p, n, sz, approx_sqrt(n), kth, cmp);
+  PROBE3(quickselect__entry, p, n, kth);
+  STATS_BEGIN(t);
+  rs3_5_2_find_kth(p, n, sz, approx_sqrt(n), kth, cmp, NULL);
+  STATS_END(QUICKSORT_MM_STATS_QUICKSELECT, t, n, sz);
+  PROBE2(quickselect__return, p, n);
+}
+
+
+// Quickselect with a cancellation callback.
+// It returns 0 if the k-th element is set to the k-th position.
+// When cancel(arg) returns non-zero, 1 is returned and the array is
+// split into three blocks, such that no element is greater than an
+// element of a later block, and the middle block contains the k-th position.
+// A null cancel never cancels.
+int quicksort_mm_quickselect_cancellable(void *p, size_t n, size_t sz, size_t kth, comparator cmp, int (*cancel)(void *), void *arg)
+{
+  if (!p) return 0;
+  if (sz == 0) return 0;
+  if (n == 0) return 0;
+  if (n <= kth) return 0;
+
+  char *begin = (char *)p;
+  char *end = begin + n*sz;
+
+  if (end < begin) return 0; // In this case the routine does not work.
+
+  cancel_token token = {cancel, arg, 0};
+  rs3_5_2_find_kth(p, n, sz, approx_sqrt(n), kth, cmp, &token);
+  return token.cancelled;
+}
+
+
+
+// ======================================================
+// Quickselect returning the range of the elements equal to the k-th
+//
+// The k-th element is set to the k-th position as quickselect,
+// and the range [*lo, *hi) of the elements equal to it is stored.
+// The routine stops as soon as the block equal to the pivot in
+// the 3-way partition contains the k-th position.
+// ======================================================
+void quicksort_mm_select_equal_range(void *p, size_t n, size_t sz, size_t kth, comparator cmp, size_t *lo, size_t *hi)
+{
+  if (!lo || !hi) return;
+  *lo = *hi = n;
+  if (!p) return;
+  if (sz == 0) return;
+  if (n == 0) return;
+  if (n <= kth) return;
+
+  char *begin = (char *)p;
+  char *end = begin + n*sz;
+
+  if (end < begin) return; // In this case the routine does not work.
+
+  size_t offset = 0;  // position of begin in the input array
+  size_t thin = approx_sqrt(n);
+  for (;;) {
+    // Boundary condition, as in quickselect
+    if (n < QUICKSORT_MM_SELECT_CUTOFF) {
+      small_sort(begin, n, sz, cmp);
+      char *k = begin + kth*sz;
+      size_t l = kth, h = kth + 1;
+      while (l > 0 && cmp(begin + (l-1)*sz, k) == 0) l--;
+      while (h < n && cmp(begin + h*sz, k) == 0) h++;
+      *lo = offset + l;
+      *hi = offset + h;
+      return;
+    }
+
+    char *pivot = rs3_5_2_pick_pivot(begin, n, sz, thin, cmp);
+    char *eq_end;
+    char *eq_begin = partition3(begin, pivot, n, sz, cmp, &eq_end);
+
+    size_t nl = (size_t)(eq_begin - begin) / sz;
+    size_t nle = (size_t)(eq_end - begin) / sz;
+
+    if (kth < nl) {
+      n = nl;
+    }
+    else if (nle <= kth) {
+      begin = eq_end;
+      n -= nle;
+      kth -= nle;
+      offset += nle;
+    }
+    else {
+      *lo = offset + nl;
+      *hi = offset + nle;
+      return;
+    }
+    thin = 2;
+  }
+}
+
+
+
+#ifdef QUICKSORT_MM_ASYNC
+// ======================================================
+// Asynchronous quicksort on a shared thread pool
+//
+// Compile with -DQUICKSORT_MM_ASYNC and link the pthread library.
+//
+// A task partitions its subarray, queues one side as a new task and
+// continues with the other, until the subarray is shorter than
+// ASYNC_TASK_SIZE. The workers of the pool are started at the first
+// call and shared by all the sorts of the process, until
+// quicksort_mm_async_shutdown() finishes the queued tasks and joins
+// them; the next call starts them again.
+// When the resources are not available, the sort is done in the
+// calling thread.
+// ======================================================
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ASYNC_TASK_SIZE ((size_t)1 << 15)
+#define ASYNC_MAX_THREADS 256
+
+typedef struct {
+  size_t sz;
+  comparator cmp;
+  void (*done)(void *);
+  void *arg;
+  size_t pending;   // number of unfinished tasks (guarded by the pool mutex)
+} async_job;
+
+typedef struct async_task {
+  struct async_task *next;
+  async_job *job;
+  char *begin;
+  char *end;
+  size_t thin;
+} async_task;
+
+static struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  async_task *head;
+  async_task *tail;
+  size_t tasks;     // queued and running tasks
+  int started;
+  int stop;
+  int nthreads;
+} async_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, 0, 0, 0};
+
+static pthread_t async_threads[ASYNC_MAX_THREADS];
+
+static void async_run(async_task *task);
+
+
+static void *async_worker(void *unused)
+{
+  (void)unused;
+  for (;;) {
+    pthread_mutex_lock(&async_pool.mutex);
+    // On stop, the workers exit when no task is left, since a running
+    // task may queue new ones.
+    while (!async_pool.head && !(async_pool.stop && async_pool.tasks == 0)) {
+      pthread_cond_wait(&async_pool.cond, &async_pool.mutex);
+    }
+    async_task *task = async_pool.head;
+    if (!task) {
+      pthread_mutex_unlock(&async_pool.mutex);
+      return NULL;
+    }
+    async_pool.head = task->next;
+    if (!async_pool.head) async_pool.tail = NULL;
+    pthread_mutex_unlock(&async_pool.mutex);
+
+    async_run(task);
+
+    pthread_mutex_lock(&async_pool.mutex);
+    if (--async_pool.tasks == 0 && async_pool.stop) pthread_cond_broadcast(&async_pool.cond);
+    pthread_mutex_unlock(&async_pool.mutex);
+  }
+}
+
+
+// Start the workers if not yet; it returns the number of the workers.
+static int async_pool_start(void)
+{
+  pthread_mutex_lock(&async_pool.mutex);
+  if (!async_pool.started) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > ASYNC_MAX_THREADS) n = ASYNC_MAX_THREADS;
+
+    for (long i = 0; i < n; i++) {
+      if (pthread_create(&async_threads[i], NULL, async_worker, NULL) != 0) break;
+      async_pool.nthreads++;
+    }
+    async_pool.started = 1;
+  }
+  int nthreads = async_pool.nthreads;
+  pthread_mutex_unlock(&async_pool.mutex);
+  return nthreads;
+}
+
+
+// Queue the subarray as a new task of the job, and return 1.
+// If a task cannot be allocated, the subarray is sorted here and 0 is
+// returned; the job is not finished by it.
+static int async_spawn(async_job *job, char *begin, char *end, size_t thin)
+{
+  async_task *task = malloc(sizeof(async_task));
+  if (!task) {
+    quicksort_body(begin, end, job->sz, job->cmp, thin, NULL);
+    return 0;
+  }
+  task->next = NULL;
+  task->job = job;
+  task->begin = begin;
+  task->end = end;
+  task->thin = thin;
+
+  pthread_mutex_lock(&async_pool.mutex);
+  job->pending++;
+  async_pool.tasks++;
+  if (async_pool.tail) async_pool.tail->next = task;
+  else async_pool.head = task;
+  async_pool.tail = task;
+  pthread_mutex_unlock(&async_pool.mutex);
+  pthread_cond_signal(&async_pool.cond);
+  return 1;
+}
+
+
+static void async_run(async_task *task)
+{
+  async_job *job = task->job;
+  char *begin = task->begin;
+  char *end = task->end;
+  size_t thin = task->thin;
+  size_t sz = job->sz;
+  free(task);
+
+  while ((size_t)(end - begin) / sz >= ASYNC_TASK_SIZE) {
+    if (thin < 10) thin = 10;
+    size_t n = (size_t)(end - begin) / sz;
+    char *pivot = rs3_5_2_pick_pivot(begin, n, sz, thin, job->cmp);
+    char *pivot_pos = partition(begin, pivot, n, sz, job->cmp);
+    thin = thin*12/17;
+
+    // Queue the shorter side, and continue with the longer one.
+    if (pivot_pos - begin < end - pivot_pos) {
+      async_spawn(job, begin, pivot_pos, thin);
+      begin = pivot_pos + sz;
+    }
+    else {
+      async_spawn(job, pivot_pos + sz, end, thin);
+      end = pivot_pos;
+    }
+  }
+  quicksort_body(begin, end, sz, job->cmp, thin, NULL);
+
+  pthread_mutex_lock(&async_pool.mutex);
+  int last = (--job->pending == 0);
+  pthread_mutex_unlock(&async_pool.mutex);
+
+  if (last) {
+    if (job->done) job->done(job->arg);
+    free(job);
+  }
+}
+
+
+// Sort the array on the shared pool, and call done(arg) when finished.
+// The call returns at once; done may be called from the calling thread
+// (e.g. for an empty array) or from a worker of the pool.
+void quicksort_mm_quicksort_async(void *p, size_t n, size_t sz, comparator cmp, void (*done)(void *), void *arg)
+{
+  char *begin = (char *)p;
+  char *end = begin + n*sz;
+
+  if (!p || n == 0 || sz == 0 || end < begin) {
+    if (done) done(arg);
+    return;
+  }
+
+  int nthreads = async_pool_start();
+
+  async_job *job = malloc(sizeof(async_job));
+  if (!job || nthreads == 0) {
+    free(job);
+    quicksort_body(begin, end, sz, cmp, approx_sqrt(n), NULL);
+    if (done) done(arg);
+    return;
+  }
+  job->sz = sz;
+  job->cmp = cmp;
+  job->done = done;
+  job->arg = arg;
+  job->pending = 0;
+
+  // Without a task, no worker finishes the job.
+  if (!async_spawn(job, begin, end, approx_sqrt(n))) {
+    free(job);
+    if (done) done(arg);
+  }
+}
+
+
+// Finish the sorts, and join the workers of the pool.
+// No sort may be started during the call.
+void quicksort_mm_async_shutdown(void)
+{
+  pthread_mutex_lock(&async_pool.mutex);
+  if (!async_pool.started) {
+    pthread_mutex_unlock(&async_pool.mutex);
+    return;
+  }
+  async_pool.stop = 1;
+  pthread_cond_broadcast(&async_pool.cond);
+  int nthreads = async_pool.nthreads;
+  pthread_mutex_unlock(&async_pool.mutex);
+
+  for (int i = 0; i < nthreads; i++) pthread_join(async_threads[i], NULL);
+
+  pthread_mutex_lock(&async_pool.mutex);
+  async_pool.started = 0;
+  async_pool.stop = 0;
+  async_pool.nthreads = 0;
+  pthread_mutex_unlock(&async_pool.mutex);
+}
+#endif
+
+
+
+#ifdef QUICKSORT_MM_STATS
+// ======================================================
+// Latency histograms of the calls
+//
+// Compile with -DQUICKSORT_MM_STATS and link the pthread library.
+//
+// quicksort_mm_quicksort and quicksort_mm_quickselect record their
+// wall time into the histogram of the class of (n, size) in a block
+// of the calling thread, so that the calls do not share cache lines.
+// The histograms are log-linear (HDR style): 2^STATS_SUB_BITS buckets
+// per power of 2 nanoseconds, i.e. 12.5% resolution. A histogram is
+// allocated at its first record. The readers merge the blocks of all
+// the threads; the block of an exited thread is kept and reused.
+// ======================================================
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STATS_OPS 2
+#define STATS_N_CLASSES 11     // n < 4^2, 4^3, ..., 4^11, and more
+#define STATS_SIZE_CLASSES 5   // size <= 4, 8, 16, 64, and more
+#define STATS_SUB_BITS 3
+#define STATS_BUCKETS ((64 - STATS_SUB_BITS + 1) << STATS_SUB_BITS)
+
+// A counter is written by its thread only and read by any thread.
+#if defined(__GNUC__)
+#define STATS_LOAD(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define STATS_STORE(p, x) __atomic_store_n(p, x, __ATOMIC_RELAXED)
+#define STATS_PUBLISH(p, x) __atomic_store_n(p, x, __ATOMIC_RELEASE)
+#define STATS_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#else
+#define STATS_LOAD(p) (*(p))
+#define STATS_STORE(p, x) (*(p) = (x))
+#define STATS_PUBLISH(p, x) (*(p) = (x))
+#define STATS_ACQUIRE(p) (*(p))
+#endif
+
+typedef struct {
+  uint64_t count;
+  uint64_t elements;
+  uint64_t sum_ns;
+  uint64_t max_ns;
+  uint64_t buckets[STATS_BUCKETS];
+} stats_histogram;
+
+typedef struct stats_block {
+  struct stats_block *next;
+  int in_use;
+  stats_histogram *hist[STATS_OPS][STATS_N_CLASSES][STATS_SIZE_CLASSES];
+} stats_block;
+
+static struct {
+  pthread_mutex_t mutex;
+  stats_block *head;
+} stats_registry = {PTHREAD_MUTEX_INITIALIZER, NULL};
+
+static pthread_key_t stats_key;
+static int stats_key_ok;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+
+static const char *const stats_op_names[STATS_OPS] = {"quicksort", "quickselect"};
+static const size_t stats_size_bounds[STATS_SIZE_CLASSES - 1] = {4, 8, 16, 64};
+
+
+static uint64_t stats_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+static int floor_log2(uint64_t x)
+{
+  int e = 0;
+  while (x >>= 1) e++;
+  return e;
+}
+
+
+static int stats_n_class(size_t n)
+{
+  int c = n < 2 ? 0 : floor_log2(n) / 2 - 1;
+  if (c < 0) c = 0;
+  return c < STATS_N_CLASSES ? c : STATS_N_CLASSES - 1;
+}
+
+
+static int stats_size_class(size_t sz)
+{
+  int c = 0;
+  while (c < STATS_SIZE_CLASSES - 1 && sz > stats_size_bounds[c]) c++;
+  return c;
+}
+
+
+static int stats_bucket(uint64_t ns)
+{
+  if (ns < (1u << STATS_SUB_BITS)) return (int)ns;
+  int e = floor_log2(ns);
+  return ((e - STATS_SUB_BITS + 1) << STATS_SUB_BITS) + (int)(ns >> (e - STATS_SUB_BITS)) - (1 << STATS_SUB_BITS);
+}
+
+
+// The least value of the next bucket
+// The last bucket has no end (2^64 ns); UINT64_MAX stands for +Inf.
+static uint64_t stats_bucket_end(int b)
+{
+  if (b < (1 << STATS_SUB_BITS)) return (uint64_t)b + 1;
+  if (b == STATS_BUCKETS - 1) return UINT64_MAX;
+  int e = (b >> STATS_SUB_BITS) + STATS_SUB_BITS - 1;
+  uint64_t m = (uint64_t)(b & ((1 << STATS_SUB_BITS) - 1)) + (1u << STATS_SUB_BITS) + 1;
+  return m << (e - STATS_SUB_BITS);
+}
+
+
+// The block is left for another thread when its thread exits.
+static void stats_release(void *block)
+{
+  pthread_mutex_lock(&stats_registry.mutex);
+  ((stats_block *)block)->in_use = 0;
+  pthread_mutex_unlock(&stats_registry.mutex);
+}
+
+
+static void stats_init(void)
+{
+  stats_key_ok = (pthread_key_create(&stats_key, stats_release) == 0);
+}
+
+
+static stats_block *stats_local(void)
+{
+  pthread_once(&stats_once, stats_init);
+  if (!stats_key_ok) return NULL;
+  stats_block *block = pthread_getspecific(stats_key);
+  if (block) return block;
+
+  pthread_mutex_lock(&stats_registry.mutex);
+  for (block = stats_registry.head; block && block->in_use; block = block->next) {}
+  if (!block) {
+    block = calloc(1, sizeof(stats_block));
+    if (block) {
+      block->next = stats_registry.head;
+      stats_registry.head = block;
+    }
+  }
+  if (block) block->in_use = 1;
+  pthread_mutex_unlock(&stats_registry.mutex);
+
+  if (block && pthread_setspecific(stats_key, block) != 0) {
+    stats_release(block);
+    block = NULL;
+  }
+  return block;
+}
+
+
+static void stats_record(int op, size_t n, size_t sz, uint64_t begin)
+{
+  uint64_t ns = stats_now() - begin;
+  stats_block *block = stats_local();
+  if (!block) return;
+
+  stats_histogram **slot = &block->hist[op][stats_n_class(n)][stats_size_class(sz)];
+  stats_histogram *h = *slot;
+  if (!h) {
+    h = calloc(1, sizeof(stats_histogram));
+    if (!h) return;
+    STATS_PUBLISH(slot, h);
+  }
+  uint64_t *bucket = &h->buckets[stats_bucket(ns)];
+  STATS_STORE(bucket, STATS_LOAD(bucket) + 1);
+  STATS_STORE(&h->count, STATS_LOAD(&h->count) + 1);
+  STATS_STORE(&h->elements, STATS_LOAD(&h->elements) + n);
+  STATS_STORE(&h->sum_ns, STATS_LOAD(&h->sum_ns) + ns);
+  if (ns > STATS_LOAD(&h->max_ns)) STATS_STORE(&h->max_ns, ns);
+}
+
+
+// Merge the histograms of a class over the threads; 0 if none recorded.
+// The caller holds the registry mutex.
+static int stats_merge(int op, int nc, int zc, stats_histogram *out)
+{
+  int found = 0;
+  memset(out, 0, sizeof(stats_histogram));
+  for (stats_block *block = stats_registry.head; block; block = block->next) {
+    stats_histogram *h = STATS_ACQUIRE(&block->hist[op][nc][zc]);
+    if (!h) continue;
+    found = 1;
+    out->count += STATS_LOAD(&h->count);
+    out->elements += STATS_LOAD(&h->elements);
+    out->sum_ns += STATS_LOAD(&h->sum_ns);
+    uint64_t m = STATS_LOAD(&h->max_ns);
+    if (m > out->max_ns) out->max_ns = m;
+    for (int b = 0; b < STATS_BUCKETS; b++) out->buckets[b] += STATS_LOAD(&h->buckets[b]);
+  }
+  return found;
+}
+
+
+// The upper end of the bucket of the q-quantile
+static double stats_quantile(const stats_histogram *h, double q)
+{
+  uint64_t total = 0;
+  for (int b = 0; b < STATS_BUCKETS; b++) total += h->buckets[b];
+  if (total == 0) return 0;
+
+  double rank = q * (double)total;
+  uint64_t sum = 0;
+  for (int b = 0; b < STATS_BUCKETS; b++) {
+    sum += h->buckets[b];
+    if ((double)sum >= rank && sum > 0) {
+      uint64_t end = stats_bucket_end(b) - 1;
+      return (double)(end < h->max_ns ? end : h->max_ns) * 1e-9;
+    }
+  }
+  return (double)h->max_ns * 1e-9;
+}
+
+
+int quicksort_mm_stats_read(int op, size_t n, size_t sz, quicksort_mm_stats *out)
+{
+  if (op < 0 || op >= STATS_OPS || !out) return -1;
+
+  stats_histogram *h = malloc(sizeof(stats_histogram));
+  if (!h) return -1;
+  pthread_mutex_lock(&stats_registry.mutex);
+  stats_merge(op, stats_n_class(n), stats_size_class(sz), h);
+  pthread_mutex_unlock(&stats_registry.mutex);
+
+  out->count = h->count;
+  out->elements = h->elements;
+  out->sum_seconds = (double)h->sum_ns * 1e-9;
+  out->max_seconds = (double)h->max_ns * 1e-9;
+  out->p50_seconds = stats_quantile(h, 0.50);
+  out->p90_seconds = stats_quantile(h, 0.90);
+  out->p99_seconds = stats_quantile(h, 0.99);
+  free(h);
+  return 0;
+}
+
+
+// The labels of the class (the upper bounds of n and size)
+static void stats_labels(char *buf, size_t len, int op, int nc, int zc)
+{
+  char nmax[32] = "+Inf", szmax[32] = "+Inf";
+  if (nc < STATS_N_CLASSES - 1) snprintf(nmax, sizeof nmax, "%llu", (1ull << (2*nc + 4)) - 1);
+  if (zc < STATS_SIZE_CLASSES - 1) snprintf(szmax, sizeof szmax, "%llu", (unsigned long long)stats_size_bounds[zc]);
+  snprintf(buf, len, "op=\"%s\",n_max=\"%s\",size_max=\"%s\"", stats_op_names[op], nmax, szmax);
+}
+
+
+static int stats_write(FILE *f, const stats_histogram *hist)
+{
+  char labels[128];
+  const stats_histogram *h;
+
+  fprintf(f, "# HELP quicksort_mm_call_seconds Wall time of the calls by the class of n and the element size.\n");
+  fprintf(f, "# TYPE quicksort_mm_call_seconds histogram\n");
+  h = hist;
+  for (int op = 0; op < STATS_OPS; op++) {
+    for (int nc = 0; nc < STATS_N_CLASSES; nc++) {
+      for (int zc = 0; zc < STATS_SIZE_CLASSES; zc++, h++) {
+        if (h->count == 0) continue;
+        stats_labels(labels, sizeof labels, op, nc, zc);
+        // The buckets of le = 2^k ns (about 1us to 69s) are exact.
+        uint64_t cum = 0;
+        int b = 0;
+        for (int k = 10; k <= 36; k += 2) {
+          for (; b < STATS_BUCKETS && stats_bucket_end(b) <= ((uint64_t)1 << k); b++) cum += h->buckets[b];
+          fprintf(f, "quicksort_mm_call_seconds_bucket{%s,le=\"%.9g\"} %llu\n",
+                  labels, (double)((uint64_t)1 << k) * 1e-9, (unsigned long long)cum);
+        }
+        fprintf(f, "quicksort_mm_call_seconds_bucket{%s,le=\"+Inf\"} %llu\n", labels, (unsigned long long)h->count);
+        fprintf(f, "quicksort_mm_call_seconds_sum{%s} %.9g\n", labels, (double)h->sum_ns * 1e-9);
+        fprintf(f, "quicksort_mm_call_seconds_count{%s} %llu\n", labels, (unsigned long long)h->count);
+      }
+    }
+  }
+
+  fprintf(f, "# HELP quicksort_mm_elements_total Elements passed to the calls.\n");
+  fprintf(f, "# TYPE quicksort_mm_elements_total counter\n");
+  h = hist;
+  for (int op = 0; op < STATS_OPS; op++) {
+    for (int nc = 0; nc < STATS_N_CLASSES; nc++) {
+      for (int zc = 0; zc < STATS_SIZE_CLASSES; zc++, h++) {
+        if (h->count == 0) continue;
+        stats_labels(labels, sizeof labels, op, nc, zc);
+        fprintf(f, "quicksort_mm_elements_total{%s} %llu\n", labels, (unsigned long long)h->elements);
+      }
+    }
+  }
+  return ferror(f) ? -1 : 0;
+}
+
+
+// Write all the histograms in the Prometheus text format.
+// The file is replaced atomically (written to path.tmp and renamed), as
+// the textfile collector of node_exporter expects.
+int quicksort_mm_stats_write_prometheus(const char *path)
+{
+  size_t nhist = (size_t)STATS_OPS * STATS_N_CLASSES * STATS_SIZE_CLASSES;
+  stats_histogram *hist = malloc(nhist * sizeof(stats_histogram));
+  size_t len = strlen(path);
+  char *tmp = malloc(len + 5);
+  if (!hist || !tmp) {
+    free(hist);
+    free(tmp);
+    return -1;
+  }
+  memcpy(tmp, path, len);
+  memcpy(tmp + len, ".tmp", 5);
+
+  stats_histogram *h = hist;
+  pthread_mutex_lock(&stats_registry.mutex);
+  for (int op = 0; op < STATS_OPS; op++) {
+    for (int nc = 0; nc < STATS_N_CLASSES; nc++) {
+      for (int zc = 0; zc < STATS_SIZE_CLASSES; zc++) stats_merge(op, nc, zc, h++);
+    }
+  }
+  pthread_mutex_unlock(&stats_registry.mutex);
+
+  int result = -1;
+  FILE *f = fopen(tmp, "w");
+  if (f) {
+    result = stats_write(f, hist);
+    if (fclose(f) != 0) result = -1;
+    if (result == 0 && rename(tmp, path) != 0) result = -1;
+    if (result != 0) remove(tmp);
+  }
+  free(hist);
+  free(tmp);
+  return result;
 }
+#endif
@@ -17,6 +17,65 @@ extern "C" {
 
 void quicksort_mm_quicksort(void *, size_t, size_t, int(const void *, const void *));
 void quicksort_mm_quickselect(void *, size_t, size_t, size_t, int(const void *, const void *));
+// The cancellable variants return 1 when cancel(arg) returned non-zero.
+// A null cancel never cancels.
+int quicksort_mm_quicksort_cancellable(void *, size_t, size_t, int(const void *, const void *), int (*)(void *), void *);
+int quicksort_mm_quickselect_cancellable(void *, size_t, size_t, size_t, int(const void *, const void *), int (*)(void *), void *);
+void quicksort_mm_select_equal_range(void *, size_t, size_t, size_t, int(const void *, const void *), size_t *, size_t *);
+
+#ifdef QUICKSORT_MM_ASYNC
+// Compile the callers with QUICKSORT_MM_ASYNC as well.
+void quicksort_mm_quicksort_async(void *, size_t, size_t, int(const void *, const void *), void (*)(void *), void *);
+void quicksort_mm_async_shutdown(void);
+#endif
+
+// Phase hooks, called around the phases when compiled with QUICKSORT_MM_PHASE_HOOKS.
+// They are defined by the user, e.g. to read performance counters.
+// The phases nest: the pivot selection runs partitions of the samples.
+enum {
+  QUICKSORT_MM_PHASE_PIVOT,
+  QUICKSORT_MM_PHASE_PARTITION,
+  QUICKSORT_MM_PHASE_LEAF
+};
+#ifdef QUICKSORT_MM_PHASE_HOOKS
+void quicksort_mm_phase_begin(int);
+void quicksort_mm_phase_end(int);
+#endif
+
+// USDT probes of the provider quicksort_mm, compiled in with QUICKSORT_MM_USDT
+// when <sys/sdt.h> is available; each is a NOP until a tracer attaches:
+//   quicksort__entry(p, n, size), quicksort__return(p, n),
+//   quickselect__entry(p, n, kth), quickselect__return(p, n),
+//   pivot(p, n, index of the pivot), partition(p, n, size of the left side)
+// where p and n are of the (sub)array.
+
+// Bytes moved by the swaps (2 x element size per swap) and the leaf sort, counted when
+// compiled with QUICKSORT_MM_COUNT_SWAPS (quicksort_mm.c only); the user may reset it.
+#ifdef QUICKSORT_MM_COUNT_SWAPS
+extern size_t quicksort_mm_swap_bytes;
+#endif
+
+// Latency histograms of quicksort_mm_quicksort/quickselect, by the
+// class of n (< 16, then powers of 4 up to 4^11) and of the element size
+// (<= 4, 8, 16, 64 bytes, and more). Available when compiled with
+// QUICKSORT_MM_STATS (and the pthread library); compile the callers with
+// QUICKSORT_MM_STATS as well.
+#ifdef QUICKSORT_MM_STATS
+enum {
+  QUICKSORT_MM_STATS_QUICKSORT,
+  QUICKSORT_MM_STATS_QUICKSELECT
+};
+typedef struct {
+  unsigned long long count;       // calls
+  unsigned long long elements;    // sum of n
+  double sum_seconds;
+  double p50_seconds, p90_seconds, p99_seconds, max_seconds;
+} quicksort_mm_stats;
+// Merged over the threads for the class of (n, size); 0 on success.
+int quicksort_mm_stats_read(int, size_t, size_t, quicksort_mm_stats *);
+// All the classes in the Prometheus text format; 0 on success.
+int quicksort_mm_stats_write_prometheus(const char *);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,290 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// The C interface (quicksort_mm.h) implemented by the C++ version.
+//
+// This file is linked instead of quicksort_mm.c, so that the C callers
+// get the C++ routines without changes of the sources:
+//
+//   c++ -std=c++11 -O3 -DNDEBUG -Isrc/c -Isrc/cc -c src/c/quicksort_mm_cc.cc
+//   cc -O3 -Isrc/c -c your_program.c
+//   c++ your_program.o quicksort_mm_cc.o -o your_program
+//
+// The element size is dispatched to the instances for fixed-size
+// elements (1, 2, 4, 8, 16 and 32 bytes), compared through the C
+// comparator; an array not aligned for such an element is sorted as
+// elements of the same size without alignment. The other sizes are
+// sorted as records of the size given at run time: the iterator returns
+// a proxy of the record, and the records are swapped by memcpy. No
+// memory is allocated.
+//
+// It provides quicksort_mm_quicksort, quicksort_mm_quickselect, their
+// cancellable variants and quicksort_mm_select_equal_range. The async
+// sort and the latency histograms are in quicksort_mm.c only; the phase
+// hooks and the USDT probes are those of the C++ version.
+// ======================================================
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include "quicksort_mm.h"
+#include "quicksort_mm.hh"
+
+// The swaps are counted by quicksort_mm.c only.
+#ifdef QUICKSORT_MM_COUNT_SWAPS
+#error "QUICKSORT_MM_COUNT_SWAPS is not supported by quicksort_mm_cc.cc; use quicksort_mm.c"
+#endif
+
+namespace {
+  typedef int (*comparator)(const void *, const void *);
+
+  // An element of N bytes
+  // The copies (e.g. the pivot) are passed to the C comparator, so they
+  // are aligned as any type of N bytes may need; Align = 1 is for the
+  // arrays without that alignment.
+  template<size_t N, size_t Align = (N < alignof(std::max_align_t) ? N : alignof(std::max_align_t))>
+  struct alignas(Align) bytes {
+    unsigned char b[N];
+  };
+
+  // The adapter of the C comparator
+  template<class T>
+  struct c_less {
+    comparator cmp;
+    bool operator()(const T &a, const T &b) const { return cmp(&a, &b) < 0; }
+  };
+
+  // A record of the size given at run time
+  // It refers to the bytes in the array, and is swapped by std::iter_swap.
+  struct record {
+    char *p;
+    size_t sz;
+  };
+
+  void swap(record a, record b)
+  {
+    if (a.p == b.p) return;
+    char *p = a.p, *q = b.p;
+    size_t sz = a.sz;
+    // by words, and the rest by bytes
+    for (; sz >= sizeof(std::uint64_t); sz -= sizeof(std::uint64_t)) {
+      std::uint64_t x, y;
+      std::memcpy(&x, p, sizeof(x));
+      std::memcpy(&y, q, sizeof(y));
+      std::memcpy(p, &y, sizeof(y));
+      std::memcpy(q, &x, sizeof(x));
+      p += sizeof(x);
+      q += sizeof(y);
+    }
+    for (; sz > 0; sz--) {
+      char tmp = *p;
+      *p++ = *q;
+      *q++ = tmp;
+    }
+  }
+
+  // The iterator over the records, returning the proxies
+  class record_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef record value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef void pointer;
+    typedef record reference;
+
+    record_iterator(char *p, size_t sz) : p_(p), sz_(sz) {}
+
+    record operator*() const { return record{p_, sz_}; }
+    record operator[](difference_type i) const { return record{p_ + i*difference_type(sz_), sz_}; }
+
+    record_iterator &operator++() { p_ += sz_; return *this; }
+    record_iterator &operator--() { p_ -= sz_; return *this; }
+    record_iterator operator++(int) { record_iterator it = *this; p_ += sz_; return it; }
+    record_iterator operator--(int) { record_iterator it = *this; p_ -= sz_; return it; }
+    record_iterator &operator+=(difference_type i) { p_ += i*difference_type(sz_); return *this; }
+    record_iterator &operator-=(difference_type i) { p_ -= i*difference_type(sz_); return *this; }
+    record_iterator operator+(difference_type i) const { return record_iterator(p_ + i*difference_type(sz_), sz_); }
+    record_iterator operator-(difference_type i) const { return record_iterator(p_ - i*difference_type(sz_), sz_); }
+    difference_type operator-(const record_iterator &it) const { return (p_ - it.p_) / difference_type(sz_); }
+
+    bool operator==(const record_iterator &it) const { return p_ == it.p_; }
+    bool operator!=(const record_iterator &it) const { return p_ != it.p_; }
+    bool operator<(const record_iterator &it) const { return p_ < it.p_; }
+    bool operator>(const record_iterator &it) const { return p_ > it.p_; }
+    bool operator<=(const record_iterator &it) const { return p_ <= it.p_; }
+    bool operator>=(const record_iterator &it) const { return p_ >= it.p_; }
+
+  private:
+    char *p_;
+    size_t sz_;
+  };
+
+  // The adapter of the C comparator for the records
+  struct c_less_record {
+    comparator cmp;
+    bool operator()(record a, record b) const { return cmp(a.p, b.p) < 0; }
+  };
+
+  struct cancel_adapter {
+    int (*func)(void *);
+    void *arg;
+    bool operator()() const { return func && func(arg) != 0; }
+  };
+
+
+  // ======================================================
+  // Operations
+  //
+  // An operation is applied to [first, last) of the elements or the
+  // records with a less-than comparator.
+  // ======================================================
+  struct sort_op {
+    typedef int result_type;
+
+    template<class It, class Less>
+    int operator()(It first, It last, Less less) const
+    {
+      quicksort_mm::quicksort(first, last, less);
+      return 0;
+    }
+  };
+
+  struct select_op {
+    typedef int result_type;
+    size_t kth;
+
+    template<class It, class Less>
+    int operator()(It first, It last, Less less) const
+    {
+      quicksort_mm::quickselect(first, first + kth, last, less);
+      return 0;
+    }
+  };
+
+  // The cancellable ones return 1 if cancelled.
+  struct sort_cancellable_op {
+    typedef int result_type;
+    cancel_adapter cancel;
+
+    template<class It, class Less>
+    int operator()(It first, It last, Less less) const
+    {
+      return quicksort_mm::quicksort(first, last, less, cancel) ? 0 : 1;
+    }
+  };
+
+  struct select_cancellable_op {
+    typedef int result_type;
+    size_t kth;
+    cancel_adapter cancel;
+
+    template<class It, class Less>
+    int operator()(It first, It last, Less less) const
+    {
+      return quicksort_mm::quickselect(first, first + kth, last, less, cancel) ? 0 : 1;
+    }
+  };
+
+  struct equal_range_op {
+    typedef int result_type;
+    size_t kth;
+    size_t *lo;
+    size_t *hi;
+
+    template<class It, class Less>
+    int operator()(It first, It last, Less less) const
+    {
+      auto eq = quicksort_mm::select_equal_range(first, first + kth, last, less);
+      *lo = size_t(eq.first - first);
+      *hi = size_t(eq.second - first);
+      return 0;
+    }
+  };
+
+
+  // ======================================================
+  // Dispatch by the element size
+  // ======================================================
+  template<size_t N, class Op>
+  typename Op::result_type fixed(char *p, size_t n, comparator cmp, Op op)
+  {
+    typedef bytes<N> T;
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) != 0) {
+      typedef bytes<N, 1> U;
+      U *first = reinterpret_cast<U *>(p);
+      return op(first, first + n, c_less<U>{cmp});
+    }
+    T *first = reinterpret_cast<T *>(p);
+    return op(first, first + n, c_less<T>{cmp});
+  }
+
+  template<class Op>
+  typename Op::result_type dispatch(char *p, size_t n, size_t sz, comparator cmp, Op op)
+  {
+    switch (sz) {
+    case 1: return fixed<1>(p, n, cmp, op);
+    case 2: return fixed<2>(p, n, cmp, op);
+    case 4: return fixed<4>(p, n, cmp, op);
+    case 8: return fixed<8>(p, n, cmp, op);
+    case 16: return fixed<16>(p, n, cmp, op);
+    case 32: return fixed<32>(p, n, cmp, op);
+    default: return op(record_iterator(p, sz), record_iterator(p + n*sz, sz), c_less_record{cmp});
+    }
+  }
+
+  // The arguments accepted by the C version
+  bool valid(void *p, size_t n, size_t sz)
+  {
+    if (!p || n == 0 || sz == 0) return false;
+    char *begin = static_cast<char *>(p);
+    return begin + n*sz >= begin;
+  }
+}
+
+
+void quicksort_mm_quicksort(void *p, size_t n, size_t sz, comparator cmp)
+{
+  if (!valid(p, n, sz)) return;
+  dispatch(static_cast<char *>(p), n, sz, cmp, sort_op());
+}
+
+
+int quicksort_mm_quicksort_cancellable(void *p, size_t n, size_t sz, comparator cmp, int (*cancel)(void *), void *arg)
+{
+  if (!valid(p, n, sz)) return 0;
+  sort_cancellable_op op = {{cancel, arg}};
+  return dispatch(static_cast<char *>(p), n, sz, cmp, op);
+}
+
+
+void quicksort_mm_quickselect(void *p, size_t n, size_t sz, size_t kth, comparator cmp)
+{
+  if (!valid(p, n, sz) || n <= kth) return;
+  select_op op = {kth};
+  dispatch(static_cast<char *>(p), n, sz, cmp, op);
+}
+
+
+int quicksort_mm_quickselect_cancellable(void *p, size_t n, size_t sz, size_t kth, comparator cmp, int (*cancel)(void *), void *arg)
+{
+  if (!valid(p, n, sz) || n <= kth) return 0;
+  select_cancellable_op op = {kth, {cancel, arg}};
+  return dispatch(static_cast<char *>(p), n, sz, cmp, op);
+}
+
+
+void quicksort_mm_select_equal_range(void *p, size_t n, size_t sz, size_t kth, comparator cmp, size_t *lo, size_t *hi)
+{
+  if (!lo || !hi) return;
+  *lo = *hi = n;
+  if (!valid(p, n, sz) || n <= kth) return;
+  equal_range_op op = {kth, lo, hi};
+  dispatch(static_cast<char *>(p), n, sz, cmp, op);
+}
@@ -26,7 +26,76 @@
 #define QUICKSORT_MM_HH_INCLUDED
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
 #include <utility>
+#if __cplusplus >= 201703L
+#include <array>
+#if defined(__GLIBCXX__)
+#include <deque>
+#endif
+#endif
+#if __cplusplus >= 202002L
+#include <compare>
+#include <concepts>
+#endif
+
+// Under C++20, the routines are constexpr so that constant tables
+// (e.g. std::array) can be sorted at compile time.
+#if __cplusplus >= 202002L
+#define QUICKSORT_MM_CONSTEXPR constexpr
+#else
+#define QUICKSORT_MM_CONSTEXPR
+#endif
+
+// Phase hooks for profiling, as in the C version.
+// When QUICKSORT_MM_PHASE_HOOKS is defined, the user defines
+// quicksort_mm_phase_begin/end(int), which are called around the
+// phases (quicksort_mm::phase); they are skipped at compile time.
+#ifdef QUICKSORT_MM_PHASE_HOOKS
+extern "C" void quicksort_mm_phase_begin(int);
+extern "C" void quicksort_mm_phase_end(int);
+#if __cplusplus >= 202002L
+#define QUICKSORT_MM_PHASE_BEGIN(phase) \
+  do { if (!std::is_constant_evaluated()) quicksort_mm_phase_begin(phase); } while (0)
+#define QUICKSORT_MM_PHASE_END(phase) \
+  do { if (!std::is_constant_evaluated()) quicksort_mm_phase_end(phase); } while (0)
+#else
+#define QUICKSORT_MM_PHASE_BEGIN(phase) quicksort_mm_phase_begin(phase)
+#define QUICKSORT_MM_PHASE_END(phase) quicksort_mm_phase_end(phase)
+#endif
+#else
+#define QUICKSORT_MM_PHASE_BEGIN(phase) ((void)0)
+#define QUICKSORT_MM_PHASE_END(phase) ((void)0)
+#endif
+
+// USDT probes of the provider quicksort_mm, as in the C version but
+// without the pointer argument: quicksort__entry(n, size),
+// quicksort__return(n), quickselect__entry(n, k), quickselect__return(n),
+// pivot(n, index) and partition(n, size of the left side).
+// They are compiled in with QUICKSORT_MM_USDT when <sys/sdt.h> is
+// available, and are NOPs until a tracer attaches.
+#if defined(QUICKSORT_MM_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#if __cplusplus >= 202002L
+#define QUICKSORT_MM_PROBE1(name, a) \
+  do { if (!std::is_constant_evaluated()) DTRACE_PROBE1(quicksort_mm, name, a); } while (0)
+#define QUICKSORT_MM_PROBE2(name, a, b) \
+  do { if (!std::is_constant_evaluated()) DTRACE_PROBE2(quicksort_mm, name, a, b); } while (0)
+#else
+#define QUICKSORT_MM_PROBE1(name, a) DTRACE_PROBE1(quicksort_mm, name, a)
+#define QUICKSORT_MM_PROBE2(name, a, b) DTRACE_PROBE2(quicksort_mm, name, a, b)
+#endif
+#endif
+#endif
+#ifndef QUICKSORT_MM_PROBE1
+#define QUICKSORT_MM_PROBE1(name, a) ((void)0)
+#define QUICKSORT_MM_PROBE2(name, a, b) ((void)0)
+#endif
 
 namespace quicksort_mm {
   // ======================================================
@@ -35,7 +104,7 @@ namespace quicksort_mm {
 
   // Get the median of given three elements.
   template<class RAIt, class Cmp>
-  inline RAIt median3(RAIt a, RAIt b, RAIt c, Cmp cmp)
+  QUICKSORT_MM_CONSTEXPR inline RAIt median3(RAIt a, RAIt b, RAIt c, Cmp cmp)
   {
     return cmp(*a, *b)
       ? (cmp(*b, *c) ? b : (cmp(*a, *c) ? c : a))
@@ -44,7 +113,7 @@ namespace quicksort_mm {
 
   // Get the median of given five elements.
   template<class RAIt, class Cmp>
-  inline RAIt median5(RAIt a, RAIt b, RAIt c, RAIt d, RAIt e, Cmp cmp)
+  QUICKSORT_MM_CONSTEXPR inline RAIt median5(RAIt a, RAIt b, RAIt c, RAIt d, RAIt e, Cmp cmp)
   {
     if (cmp(*b, *a)) std::swap(a, b);
     if (cmp(*d, *c)) std::swap(c, d);
@@ -64,7 +133,7 @@ namespace quicksort_mm {
 
   // Simple insertion sort
   template<class RAIt, class Cmp>
-  inline void insertion_sort(RAIt first, RAIt last, Cmp cmp)
+  QUICKSORT_MM_CONSTEXPR inline void insertion_sort(RAIt first, RAIt last, Cmp cmp, std::true_type)
   {
     if (first == last) return;
     for (auto current = first+1; current != last; current++) {
@@ -80,60 +149,393 @@ namespace quicksort_mm {
     }
   }
 
+  // Insertion sort for the iterators returning proxies (e.g. over the
+  // elements of a size given at run time), which have no value to hold
+  // the element to insert; it is moved down by swaps.
+  template<class RAIt, class Cmp>
+  QUICKSORT_MM_CONSTEXPR inline void insertion_sort(RAIt first, RAIt last, Cmp cmp, std::false_type)
+  {
+    if (first == last) return;
+    for (auto current = first+1; current != last; current++) {
+      for (auto cursor = current; cursor != first && cmp(*cursor, *(cursor-1)); cursor--) {
+        std::iter_swap(cursor-1, cursor);
+      }
+    }
+  }
+
+  template<class RAIt, class Cmp>
+  QUICKSORT_MM_CONSTEXPR inline void insertion_sort(RAIt first, RAIt last, Cmp cmp)
+  {
+    typedef typename std::iterator_traits<RAIt>::reference reference;
+    insertion_sort(first, last, cmp, typename std::is_reference<reference>::type());
+  }
+
+
+#if __cplusplus >= 201703L
+  // ======================================================
+  // Segmented iterators
+  //
+  // Iterators over chunked storage (e.g. std::deque) pay for the
+  // segment bookkeeping at every step. Specializing this traits class
+  // lets partition run its cursors on raw pointers within each chunk,
+  // and the subranges lying in a single chunk are handled by pointers:
+  //   pointer:           pointer type to the elements
+  //   local(it):         pointer to *it
+  //   segment_begin(it): first element of the chunk containing it
+  //   segment_end(it):   one past the last element of the chunk
+  // std::deque is supported with libstdc++, whose iterator exposes its
+  // chunk through internal members; it is declared here so that every
+  // sort of a deque sees the same specialization.
+  // ======================================================
+  template<class It>
+  struct segmented_iterator_traits {
+    static constexpr bool is_segmented = false;
+  };
+
+#if defined(__GLIBCXX__)
+  template<class T, class Ref, class Ptr>
+  struct segmented_iterator_traits<std::_Deque_iterator<T, Ref, Ptr> > {
+    typedef std::_Deque_iterator<T, Ref, Ptr> iterator;
+    typedef typename iterator::_Elt_pointer pointer;
+
+    static constexpr bool is_segmented = true;
+    static pointer local(const iterator &it) { return it._M_cur; }
+    static pointer segment_begin(const iterator &it) { return it._M_first; }
+    static pointer segment_end(const iterator &it) { return it._M_last; }
+  };
+#endif
+
+
+  // Hoare's Partition on a segmented iterator.
+  // The cursors are pointers into their current chunks; the iterator
+  // arithmetic is done only when a cursor crosses a chunk boundary.
+  template<class It, class Cmp>
+  It segmented_partition(It first, It last, It pivot, Cmp cmp)
+  {
+    typedef segmented_iterator_traits<It> traits;
+
+    if (first != pivot) std::iter_swap(first, pivot);
+    auto pv = traits::local(first);
+
+    // lp_end and hp_begin are at the offsets lo_end and hi_begin from first.
+    auto lp = traits::local(first), lp_end = traits::segment_end(first);
+    auto hp = traits::local(last), hp_begin = traits::segment_begin(last);
+    std::ptrdiff_t lo_end = lp_end - lp;
+    std::ptrdiff_t hi_begin = (last - first) - (hp - hp_begin);
+
+    for (;;) {
+      do {
+        if (hp == hp_begin) {
+          auto it = first + (hi_begin - 1);
+          hp = traits::local(it) + 1;
+          hp_begin = traits::segment_begin(it);
+          hi_begin -= hp - hp_begin;
+        }
+        hp--;
+      } while (lp != hp && cmp(*pv, *hp));
+      if (lp == hp) break;
+      do {
+        lp++;
+        if (lp == lp_end) {
+          auto it = first + lo_end;
+          lp = traits::local(it);
+          lp_end = traits::segment_end(it);
+          lo_end += lp_end - lp;
+        }
+      } while (lp != hp && cmp(*lp, *pv));
+      if (lp == hp) break;
+      std::swap(*lp, *hp);
+    }
+    std::swap(*pv, *lp);
+    return first + (lo_end - (lp_end - lp));
+  }
+
+  // Get the pointer to *first if [first, first+n) lies in a single chunk.
+  // Otherwise, null is returned.
+  template<class It>
+  typename segmented_iterator_traits<It>::pointer single_segment(It first, size_t n)
+  {
+    typedef segmented_iterator_traits<It> traits;
+    auto p = traits::local(first);
+    return n <= size_t(traits::segment_end(first) - p) ? p : nullptr;
+  }
+#endif
+
 
   // Hoare's Partition
   template<class RAIt, class Cmp>
-  RAIt partition(RAIt first, RAIt last, RAIt pivot, Cmp cmp)
+  QUICKSORT_MM_CONSTEXPR RAIt partition(RAIt first, RAIt last, RAIt pivot, Cmp cmp)
   {
-    if (first != pivot) std::swap(*first, *pivot);
+#if __cplusplus >= 201703L
+    if constexpr (segmented_iterator_traits<RAIt>::is_segmented) {
+      return segmented_partition(first, last, pivot, cmp);
+    }
+#endif
+    if (first != pivot) std::iter_swap(first, pivot);
     pivot = first;
     auto lo = first, hi = last;
+    // goto is not allowed in constexpr functions, so the loops exit by break.
     for (;;) {
-      for (;;) {
+      do {
         hi--;
-        if (lo == hi) goto PARTITION_END;
-        if (!cmp(*pivot, *hi)) break;
-      }
-      for (;;) {
+      } while (lo != hi && cmp(*pivot, *hi));
+      if (lo == hi) break;
+      do {
+        lo++;
+      } while (lo != hi && cmp(*lo, *pivot));
+      if (lo == hi) break;
+      std::iter_swap(lo, hi);
+    }
+    std::iter_swap(pivot, lo);
+    return lo;
+  }
+
+
+  // 3-way Partition (Dijkstra)
+  // [first, lo) < pivot, [lo, hi) == pivot, [hi, last) > pivot.
+  // The pivot stays at first during the loop, and is moved to the
+  // equal block at the end.
+  template<class RAIt, class Cmp>
+  QUICKSORT_MM_CONSTEXPR std::pair<RAIt, RAIt> partition3(RAIt first, RAIt last, RAIt pivot, Cmp cmp)
+  {
+    if (first != pivot) std::iter_swap(first, pivot);
+    pivot = first;
+    auto lo = first+1, cur = first+1, hi = last;
+    while (cur != hi) {
+      if (cmp(*cur, *pivot)) {
+        if (lo != cur) std::iter_swap(lo, cur);
         lo++;
-        if (lo == hi) goto PARTITION_END;
-        if (!cmp(*lo, *pivot)) break; 
+        cur++;
+      }
+      else if (cmp(*pivot, *cur)) {
+        hi--;
+        std::iter_swap(cur, hi);
+      }
+      else {
+        cur++;
       }
-      std::swap(*lo, *hi);
     }
-  PARTITION_END:;
-    std::swap(*pivot, *lo);
+    lo--;
+    if (lo != pivot) std::iter_swap(pivot, lo);
+    return std::make_pair(lo, hi);
+  }
+
+
+  // ======================================================
+  // Three-way comparators
+  //
+  // Under C++20, comparators returning std::strong_ordering or
+  // std::weak_ordering (e.g. std::compare_three_way) are accepted.
+  // They are wrapped by three_way_less so that the other routines
+  // see a boolean comparator, while partition tells "equal" from
+  // "greater" with a single call.
+  // ======================================================
+#if __cplusplus >= 202002L
+  template<class Cmp, class T>
+  concept three_way_comparator = requires(Cmp cmp, const T &a, const T &b) {
+    { cmp(a, b) } -> std::convertible_to<std::weak_ordering>;
+  };
+
+  template<class Cmp>
+  struct three_way_less {
+    Cmp cmp;
+
+    // The non-const one is for the comparators without a const call.
+    template<class T, class U>
+    constexpr bool operator()(const T &a, const U &b)
+    {
+      return cmp(a, b) < 0;
+    }
+
+    template<class T, class U>
+    constexpr bool operator()(const T &a, const U &b) const
+    {
+      return cmp(a, b) < 0;
+    }
+  };
+
+  template<class T, class Cmp>
+  constexpr auto to_less(Cmp cmp)
+  {
+    if constexpr (three_way_comparator<Cmp, T>) {
+      return three_way_less<Cmp>{cmp};
+    }
+    else {
+      return cmp;
+    }
+  }
+
+
+  // Hoare's Partition with a three-way comparator.
+  // As in the C version, two elements equal to the pivot are not swapped.
+  // The segmented iterators take segmented_partition as in the boolean case.
+  template<class RAIt, class Cmp>
+  constexpr RAIt partition(RAIt first, RAIt last, RAIt pivot, three_way_less<Cmp> less)
+  {
+    if constexpr (segmented_iterator_traits<RAIt>::is_segmented) {
+      return segmented_partition(first, last, pivot, less);
+    }
+    auto &cmp = less.cmp;
+    if (first != pivot) std::iter_swap(first, pivot);
+    pivot = first;
+    auto lo = first, hi = last;
+    for (;;) {
+      bool hi_equal = false;
+      while (--hi != lo) {
+        auto c = cmp(*hi, *pivot);
+        if (c <= 0) {
+          hi_equal = (c == 0);
+          break;
+        }
+      }
+      if (lo == hi) break;
+      bool lo_equal = false;
+      while (++lo != hi) {
+        auto c = cmp(*lo, *pivot);
+        if (c >= 0) {
+          lo_equal = (c == 0);
+          break;
+        }
+      }
+      if (lo == hi) break;
+      if (!lo_equal || !hi_equal) std::iter_swap(lo, hi);
+    }
+    std::iter_swap(pivot, lo);
     return lo;
   }
 
 
+  // 3-way Partition with a three-way comparator.
+  // Each element is compared only once.
+  template<class RAIt, class Cmp>
+  constexpr std::pair<RAIt, RAIt> partition3(RAIt first, RAIt last, RAIt pivot, three_way_less<Cmp> less)
+  {
+    auto &cmp = less.cmp;
+    if (first != pivot) std::iter_swap(first, pivot);
+    pivot = first;
+    auto lo = first+1, cur = first+1, hi = last;
+    while (cur != hi) {
+      auto c = cmp(*cur, *pivot);
+      if (c < 0) {
+        if (lo != cur) std::iter_swap(lo, cur);
+        lo++;
+        cur++;
+      }
+      else if (c > 0) {
+        hi--;
+        std::iter_swap(cur, hi);
+      }
+      else {
+        cur++;
+      }
+    }
+    lo--;
+    if (lo != pivot) std::iter_swap(pivot, lo);
+    return std::make_pair(lo, hi);
+  }
+#else
+  template<class T, class Cmp>
+  inline Cmp to_less(Cmp cmp)
+  {
+    return cmp;
+  }
+#endif
+
+
   // approximate square root
-  inline size_t approx_sqrt(size_t n)
+  // 1 for n < 4 (including 0)
+  QUICKSORT_MM_CONSTEXPR inline size_t approx_sqrt(size_t n)
   {
-    int base = -1;
-    while (0 < n) {
+    int base = 0;
+    while (4 <= n) {
       base += 1;
       n /= 4;
     }
-    return 1 << base;
+    return size_t(1) << base;
   }
 
 
+  // ======================================================
+  // Cancellation
+  //
+  // A cancellation token is a callable returning true when the routine
+  // should stop, e.g. deadline below, or a lambda reading an atomic
+  // flag. It is checked once per partition of cancel_check_size or more
+  // elements; the shorter subranges are finished once entered.
+  // ======================================================
+  const size_t cancel_check_size = 1024;
+
+  // The token of the routines without cancellation
+  struct never_cancel {
+    QUICKSORT_MM_CONSTEXPR bool operator()() const { return false; }
+  };
+
+  // Cancellation at a time point of Clock
+  template<class Clock = std::chrono::steady_clock>
+  struct deadline {
+    typename Clock::time_point time;
+
+    bool operator()() const { return Clock::now() >= time; }
+  };
+
+  // Wrap a token so that the cancellation is sticky and recorded in *cancelled.
+  template<class Cancel>
+  struct cancel_ref {
+    Cancel *cancel;
+    bool *cancelled;
+
+    QUICKSORT_MM_CONSTEXPR bool operator()() const
+    {
+      if (!*cancelled && (*cancel)()) *cancelled = true;
+      return *cancelled;
+    }
+  };
+
+
+  // Phases reported to the hooks; the values are those of the C version.
+  // They nest: the pivot selection runs partitions of the samples.
+  enum phase {
+    phase_pivot,
+    phase_partition,
+    phase_leaf
+  };
+
+
   // ======================================================
   // Median of Medians
   // ======================================================
 
   template<class RAIt, class Cmp>
-  RAIt rs3_5_2_pick_pivot(RAIt first, RAIt last, Cmp cmp, size_t s=2);
+  QUICKSORT_MM_CONSTEXPR RAIt rs3_5_2_pick_pivot(RAIt first, RAIt last, Cmp cmp, size_t s=2);
 
+  template<class RAIt, class Cmp, class Cancel = never_cancel>
+  QUICKSORT_MM_CONSTEXPR RAIt rs3_5_2_find_kth(RAIt first, RAIt last, size_t k, Cmp cmp, size_t s=2, Cancel cancel=Cancel());
+
+
+  // The group loop of rs3_5_2_pick_pivot
+  // The pseudo-median of the i-th group of 15 elements (7 from p, 1 from q
+  // and 7 from r) is moved to q+i.
   template<class RAIt, class Cmp>
-  RAIt rs3_5_2_find_kth(RAIt first, RAIt last, size_t k, Cmp cmp, size_t s=2);
+  QUICKSORT_MM_CONSTEXPR void rs3_5_2_gather_medians(RAIt p, RAIt q, RAIt r, size_t nnext, Cmp cmp)
+  {
+    for (size_t i = 0; i < nnext; i++) {
+      // median of 5 (median of 3)
+      auto x0 = median3(p+i*7+0, p+i*7+1, p+i*7+2, cmp);
+      auto x1 = median3(p+i*7+3, p+i*7+4, p+i*7+5, cmp);
+      auto x2 = median3(p+i*7+6, q+i,     r+i*7+0, cmp);
+      auto x3 = median3(r+i*7+1, r+i*7+2, r+i*7+3, cmp);
+      auto x4 = median3(r+i*7+4, r+i*7+5, r+i*7+6, cmp);
+
+      auto xx = median5(x0, x1, x2, x3, x4, cmp);
+      if (xx != q+i) std::iter_swap(xx, q+i);
+    }
+  }
 
 
   // A variant of the repeated step algorithm (3-5).
   // 3-3 and 4-4 are presented in the original paper.
   template<class RAIt, class Cmp>
-  RAIt rs3_5_2_pick_pivot(RAIt first, RAIt last, Cmp cmp, size_t s)
+  QUICKSORT_MM_CONSTEXPR RAIt rs3_5_2_pick_pivot(RAIt first, RAIt last, Cmp cmp, size_t s)
   {  
     if (s < 2) s = 2;
     size_t nelem = last - first;
@@ -149,44 +551,52 @@ namespace quicksort_mm {
     auto q = first + 7*(nelem/15);
     auto r = last - 7*nnext;
 
-    for (size_t i = 0; i < nnext; i++) {
-      // median of 5 (median of 3)
-      auto x0 = median3(p+i*7+0, p+i*7+1, p+i*7+2, cmp);
-      auto x1 = median3(p+i*7+3, p+i*7+4, p+i*7+5, cmp);
-      auto x2 = median3(p+i*7+6, q+i,     r+i*7+0, cmp);
-      auto x3 = median3(r+i*7+1, r+i*7+2, r+i*7+3, cmp);
-      auto x4 = median3(r+i*7+4, r+i*7+5, r+i*7+6, cmp);
-
-      auto xx = median5(x0, x1, x2, x3, x4, cmp);
-      if (xx != q+i) std::swap(*xx, *(q+i));
-    }
+    rs3_5_2_gather_medians(p, q, r, nnext, cmp);
 
     // Get the median of (pseudo-) medians 
     return rs3_5_2_find_kth(q, q+nnext, nnext/2, cmp, s);
   }
 
 
-  template<class RAIt, class Cmp>
-  RAIt rs3_5_2_find_kth(RAIt first, RAIt last, size_t k, Cmp cmp, size_t s)
+  // When cancelled, first+k is returned without the k-th element.
+  template<class RAIt, class Cmp, class Cancel>
+  QUICKSORT_MM_CONSTEXPR RAIt rs3_5_2_find_kth(RAIt first, RAIt last, size_t k, Cmp cmp, size_t s, Cancel cancel)
   {
     size_t nelem = last - first;
 
+#if __cplusplus >= 201703L
+    if constexpr (segmented_iterator_traits<RAIt>::is_segmented) {
+      if (auto p = single_segment(first, nelem)) {
+        return first + (rs3_5_2_find_kth(p, p+nelem, k, cmp, s, cancel) - p);
+      }
+    }
+#endif
+
     if (nelem < 7) {
+      QUICKSORT_MM_PHASE_BEGIN(phase_leaf);
       insertion_sort(first, last, cmp);
+      QUICKSORT_MM_PHASE_END(phase_leaf);
       return first+k;
     }
+    if (nelem >= cancel_check_size && cancel()) return first+k;
 
+    QUICKSORT_MM_PHASE_BEGIN(phase_pivot);
     auto pivot = rs3_5_2_pick_pivot(first, last, cmp, s);
+    QUICKSORT_MM_PHASE_END(phase_pivot);
+    QUICKSORT_MM_PROBE2(pivot, nelem, size_t(pivot - first));
+    QUICKSORT_MM_PHASE_BEGIN(phase_partition);
     auto pivotx = partition(first, last, pivot, cmp);
+    QUICKSORT_MM_PHASE_END(phase_partition);
+    QUICKSORT_MM_PROBE2(partition, nelem, size_t(pivotx - first));
   
     size_t nl = pivotx - first;
 
     // Recursive application
     if (nl < k) {
-      return rs3_5_2_find_kth(pivotx + 1, last, k-nl-1, cmp);
+      return rs3_5_2_find_kth(pivotx + 1, last, k-nl-1, cmp, 2, cancel);
     }
     else if (k < nl) {
-      return rs3_5_2_find_kth(first, first+nl, k, cmp);
+      return rs3_5_2_find_kth(first, first+nl, k, cmp, 2, cancel);
     }
     else {
       return pivotx;
@@ -201,52 +611,89 @@ namespace quicksort_mm {
   // Random:  1.44 N ln N + o(N ln N)
   // Worst:  14.76 N ln N + o(N ln N)
   // ======================================================
-  template<class RandomAccessIterator, class Compare>
-  void quicksort_body(RandomAccessIterator first, RandomAccessIterator last, Compare cmp, size_t s)
+  template<class RandomAccessIterator, class Compare, class Cancel = never_cancel>
+  QUICKSORT_MM_CONSTEXPR void quicksort_body(RandomAccessIterator first, RandomAccessIterator last, Compare cmp, size_t s, Cancel cancel = Cancel())
   {
     size_t nelem = last - first;
     if (s < 10) s = 10;
 
+#if __cplusplus >= 201703L
+    if constexpr (segmented_iterator_traits<RandomAccessIterator>::is_segmented) {
+      if (auto p = single_segment(first, nelem)) {
+        quicksort_body(p, p+nelem, cmp, s, cancel);
+        return;
+      }
+    }
+#endif
+
     // Boundary condition
     if (nelem < 16) {
+      QUICKSORT_MM_PHASE_BEGIN(phase_leaf);
       insertion_sort(first, last, cmp);
+      QUICKSORT_MM_PHASE_END(phase_leaf);
       return;
     }
+    if (nelem >= cancel_check_size && cancel()) return;
 
     // Partition
+    QUICKSORT_MM_PHASE_BEGIN(phase_pivot);
     auto pivot = rs3_5_2_pick_pivot(first, last, cmp, s);
+    QUICKSORT_MM_PHASE_END(phase_pivot);
+    QUICKSORT_MM_PROBE2(pivot, nelem, size_t(pivot - first));
+    QUICKSORT_MM_PHASE_BEGIN(phase_partition);
     auto pivot_position = partition(first, last, pivot, cmp);
+    QUICKSORT_MM_PHASE_END(phase_partition);
+    QUICKSORT_MM_PROBE2(partition, nelem, size_t(pivot_position - first));
 
     // Recursive application
     // The tail call optimization is assumed
     // 12/17 ~ 0.7059 is an approximate value of sqrt(1/2)
     if (last - pivot_position < pivot_position - first) {
-      quicksort_body(pivot_position+1, last, cmp, s*12/17);
-      quicksort_body(first, pivot_position, cmp, s*12/17);
+      quicksort_body(pivot_position+1, last, cmp, s*12/17, cancel);
+      quicksort_body(first, pivot_position, cmp, s*12/17, cancel);
     }
     else {
-      quicksort_body(first, pivot_position, cmp, s*12/17);
-      quicksort_body(pivot_position+1, last, cmp, s*12/17);
+      quicksort_body(first, pivot_position, cmp, s*12/17, cancel);
+      quicksort_body(pivot_position+1, last, cmp, s*12/17, cancel);
     }
   }
 
 
   template<class RandomAccessIterator, class Compare>
-  void quicksort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp)
+  QUICKSORT_MM_CONSTEXPR void quicksort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp)
   {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
     size_t nelem = last-first;
-    quicksort_body(first, last, cmp, approx_sqrt(nelem));
+    QUICKSORT_MM_PROBE2(quicksort__entry, nelem, sizeof(T));
+    quicksort_body(first, last, to_less<T>(cmp), approx_sqrt(nelem));
+    QUICKSORT_MM_PROBE1(quicksort__return, nelem);
   }
 
 
   template<class RandomAccessIterator>
-  void quicksort(RandomAccessIterator first, RandomAccessIterator last)
+  QUICKSORT_MM_CONSTEXPR void quicksort(RandomAccessIterator first, RandomAccessIterator last)
   {
     std::less<typename std::iterator_traits<RandomAccessIterator>::value_type> cmp;
     quicksort(first, last, cmp);
   }
 
 
+  // Quicksort with a cancellation token.
+  // It returns true if the sort is completed. When cancelled, false is
+  // returned and [first, last) is split into blocks, each of which is
+  // either sorted or not, such that no element is greater than an
+  // element of a later block.
+  template<class RandomAccessIterator, class Compare, class Cancel>
+  bool quicksort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp, Cancel cancel)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    size_t nelem = last-first;
+    bool cancelled = false;
+    quicksort_body(first, last, to_less<T>(cmp), approx_sqrt(nelem), cancel_ref<Cancel>{&cancel, &cancelled});
+    return !cancelled;
+  }
+
+
   // ======================================================
   // Quickselect with median of medians
   //
@@ -255,20 +702,262 @@ namespace quicksort_mm {
   // Worst:  26.50 N + o(N)
   // ======================================================
   template<class RandomAccessIterator, class Compare>
-  void quickselect(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last, Compare cmp)
+  QUICKSORT_MM_CONSTEXPR void quickselect(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last, Compare cmp)
   {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
     size_t k = kth - first;
     size_t nelem = last - first;
     if (nelem <= k) return;
-    rs3_5_2_find_kth(first, last, k, cmp, approx_sqrt(nelem));
+    QUICKSORT_MM_PROBE2(quickselect__entry, nelem, k);
+    rs3_5_2_find_kth(first, last, k, to_less<T>(cmp), approx_sqrt(nelem));
+    QUICKSORT_MM_PROBE1(quickselect__return, nelem);
   }
 
   template<class RandomAccessIterator>
-  void quickselect(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last)
+  QUICKSORT_MM_CONSTEXPR void quickselect(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last)
   {
     std::less<typename std::iterator_traits<RandomAccessIterator>::value_type> cmp;
     quickselect(first, kth, last, cmp);
   }
+
+
+  // Quickselect with a cancellation token.
+  // It returns true if the k-th element is set to the k-th position.
+  // When cancelled, false is returned and [first, last) is split into
+  // three blocks, such that no element is greater than an element of a
+  // later block, and the middle block contains the k-th position.
+  template<class RandomAccessIterator, class Compare, class Cancel>
+  bool quickselect(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last, Compare cmp, Cancel cancel)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    size_t k = kth - first;
+    size_t nelem = last - first;
+    if (nelem <= k) return true;
+    bool cancelled = false;
+    rs3_5_2_find_kth(first, last, k, to_less<T>(cmp), approx_sqrt(nelem), cancel_ref<Cancel>{&cancel, &cancelled});
+    return !cancelled;
+  }
+
+
+  // ======================================================
+  // Quickselect returning the range of the elements equal to the k-th
+  //
+  // The k-th element is set to the k-th position as quickselect,
+  // and the range [lo, hi) of the elements equal to it is returned.
+  // With the 3-way partition, the routine stops as soon as the
+  // block equal to the pivot contains the k-th position.
+  // ======================================================
+  template<class RandomAccessIterator, class Compare>
+  QUICKSORT_MM_CONSTEXPR std::pair<RandomAccessIterator, RandomAccessIterator>
+  select_equal_range(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last, Compare cmp)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    auto less = to_less<T>(cmp);
+    size_t k = kth - first;
+    size_t nelem = last - first;
+    if (nelem <= k) return std::make_pair(last, last);
+
+    size_t s = approx_sqrt(nelem);
+    for (;;) {
+      // Boundary condition, as in quickselect
+      if (last - first < 7) {
+        insertion_sort(first, last, less);
+        auto lo = first + k, hi = first + (k+1);
+        while (lo != first && !less(*(lo-1), first[k])) --lo;
+        while (hi != last && !less(first[k], *hi)) ++hi;
+        return std::make_pair(lo, hi);
+      }
+
+      auto pivot = rs3_5_2_pick_pivot(first, last, less, s);
+      auto eq = partition3(first, last, pivot, less);
+      size_t lo = eq.first - first;
+      size_t hi = eq.second - first;
+
+      if (k < lo) {
+        last = eq.first;
+      }
+      else if (hi <= k) {
+        first = eq.second;
+        k -= hi;
+      }
+      else {
+        return eq;
+      }
+      s = 2;
+    }
+  }
+
+  template<class RandomAccessIterator>
+  QUICKSORT_MM_CONSTEXPR std::pair<RandomAccessIterator, RandomAccessIterator>
+  select_equal_range(RandomAccessIterator first, RandomAccessIterator kth, RandomAccessIterator last)
+  {
+    std::less<typename std::iterator_traits<RandomAccessIterator>::value_type> cmp;
+    return select_equal_range(first, kth, last, cmp);
+  }
+
+
+
+#if __cplusplus >= 201703L
+  // ======================================================
+  // Fixed-size sort and select with sorting networks
+  //
+  // For std::array<T, N> with small N, the comparators of Batcher's
+  // merge exchange[6] are generated at compile time and unrolled.
+  // The selection network is obtained from the sorting network by
+  // removing the comparators which do not affect the k-th output.
+  //
+  // [6] D.E. Knuth, The Art of Computer Programming Vol.3, 5.2.2 M.
+  // ======================================================
+
+  // Arrays longer than this are sorted by quicksort instead.
+  constexpr size_t network_max_size = 64;
+
+  struct network_edge {
+    size_t lo, hi;
+  };
+
+  // Enumerate the comparators of Batcher's merge exchange for n elements.
+  // When edges is null, only the number of comparators is returned.
+  constexpr size_t merge_exchange(size_t n, network_edge *edges)
+  {
+    if (n < 2) return 0;
+    size_t t = 0;
+    while ((size_t(1) << t) < n) t++;
+
+    size_t count = 0;
+    for (size_t p = size_t(1) << (t-1); p > 0; p /= 2) {
+      size_t q = size_t(1) << (t-1), r = 0, d = p;
+      for (;;) {
+        for (size_t i = 0; i+d < n; i++) {
+          if ((i & p) != r) continue;
+          if (edges) edges[count] = network_edge{i, i+d};
+          count++;
+        }
+        if (q == p) break;
+        d = q - p;
+        q /= 2;
+        r = p;
+      }
+    }
+    return count;
+  }
+
+  // Remove the comparators which do not affect the k-th output,
+  // and return the number of the remaining ones.
+  // The remaining comparators are moved to the front of edges.
+  constexpr size_t prune_network(network_edge *edges, size_t m, size_t n, size_t k)
+  {
+    bool needed[network_max_size] = {};
+    needed[k] = true;
+    for (size_t i = m; i > 0; i--) {
+      auto &e = edges[i-1];
+      if (needed[e.lo] || needed[e.hi]) {
+        needed[e.lo] = needed[e.hi] = true;
+      }
+      else {
+        e.lo = e.hi = n;
+      }
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < m; i++) {
+      if (edges[i].lo != n) edges[count++] = edges[i];
+    }
+    return count;
+  }
+
+  template<size_t N>
+  struct sorting_network {
+    static constexpr size_t size = merge_exchange(N, nullptr);
+    static constexpr std::array<network_edge, size> edges = [] {
+      std::array<network_edge, size> e{};
+      merge_exchange(N, e.data());
+      return e;
+    }();
+  };
+
+  template<size_t N, size_t K>
+  struct selection_network {
+    static constexpr size_t size = [] {
+      auto e = sorting_network<N>::edges;
+      return prune_network(e.data(), e.size(), N, K);
+    }();
+    static constexpr std::array<network_edge, size> edges = [] {
+      auto e = sorting_network<N>::edges;
+      prune_network(e.data(), e.size(), N, K);
+      std::array<network_edge, size> r{};
+      for (size_t i = 0; i < size; i++) r[i] = e[i];
+      return r;
+    }();
+  };
+
+
+  // Order the two elements.
+  // Arithmetic types are handled without branches (conditional moves).
+  template<class RAIt, class Cmp>
+  QUICKSORT_MM_CONSTEXPR inline void compare_exchange(RAIt a, RAIt b, Cmp cmp)
+  {
+    typedef typename std::iterator_traits<RAIt>::value_type T;
+    if constexpr (std::is_arithmetic<T>::value) {
+      T x = *a, y = *b;
+      bool c = cmp(y, x);
+      *a = c ? y : x;
+      *b = c ? x : y;
+    }
+    else {
+      if (cmp(*b, *a)) std::swap(*a, *b);
+    }
+  }
+
+  template<class Network, class RAIt, class Cmp, size_t... I>
+  QUICKSORT_MM_CONSTEXPR inline void apply_network(RAIt first, Cmp cmp, std::index_sequence<I...>)
+  {
+    (void)first;
+    (void)cmp;
+    (compare_exchange(first + Network::edges[I].lo, first + Network::edges[I].hi, cmp), ...);
+  }
+
+
+  template<size_t N, class T, class Compare>
+  QUICKSORT_MM_CONSTEXPR void sort(std::array<T, N> &a, Compare cmp)
+  {
+    if constexpr (N <= network_max_size) {
+      typedef sorting_network<N> network;
+      apply_network<network>(a.begin(), to_less<T>(cmp), std::make_index_sequence<network::size>());
+    }
+    else {
+      quicksort(a.begin(), a.end(), cmp);
+    }
+  }
+
+  template<size_t N, class T>
+  QUICKSORT_MM_CONSTEXPR void sort(std::array<T, N> &a)
+  {
+    sort(a, std::less<T>());
+  }
+
+
+  // Only the K-th element is guaranteed to be placed at its position;
+  // the order of the others is unspecified.
+  template<size_t K, size_t N, class T, class Compare>
+  QUICKSORT_MM_CONSTEXPR void select(std::array<T, N> &a, Compare cmp)
+  {
+    static_assert(K < N, "K must be less than N");
+    if constexpr (N <= network_max_size) {
+      typedef selection_network<N, K> network;
+      apply_network<network>(a.begin(), to_less<T>(cmp), std::make_index_sequence<network::size>());
+    }
+    else {
+      quickselect(a.begin(), a.begin()+K, a.end(), cmp);
+    }
+  }
+
+  template<size_t K, size_t N, class T>
+  QUICKSORT_MM_CONSTEXPR void select(std::array<T, N> &a)
+  {
+    select<K>(a, std::less<T>());
+  }
+#endif
 }
 
 
@@ -0,0 +1,233 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Asynchronous quicksort on a thread pool.
+//
+// async_sort() returns a future at once. The sort is split into
+// tasks: a task partitions its range, submits one side as a new task
+// and continues with the other, until the range is shorter than
+// parallel_task_size, which is sorted by quicksort_body. Since the
+// tasks of all the sorts share the pool, several sorts progress
+// concurrently without blocking the callers.
+//
+// An executor is anything with submit(std::function<void()>);
+// shared_pool() is used by default.
+// The range must be alive until the future becomes ready.
+// If submit() throws, async_sort() rethrows it for the first task, and
+// the future gets it for the later tasks.
+// ======================================================
+
+#ifndef QUICKSORT_MM_ASYNC_HH_INCLUDED
+#define QUICKSORT_MM_ASYNC_HH_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "quicksort_mm.hh"
+
+// The hooks of quicksort_mm_trace.hh, which is included only when they
+// record; this is the only definition of the no-op ones.
+#ifdef QUICKSORT_MM_TRACE
+#include "quicksort_mm_trace.hh"
+#else
+#define QUICKSORT_MM_TRACE_BEGIN(t) ((void)0)
+#define QUICKSORT_MM_TRACE_END(name, t, n) ((void)(n))
+#define QUICKSORT_MM_TRACE_SPAWN() uint64_t(0)
+#define QUICKSORT_MM_TRACE_START(id) ((void)(id))
+#endif
+
+namespace quicksort_mm {
+  class thread_pool {
+  public:
+    explicit thread_pool(unsigned nthreads = std::thread::hardware_concurrency())
+      : stop_(false)
+    {
+      if (nthreads == 0) nthreads = 1;
+      for (unsigned i = 0; i < nthreads; i++) workers_.emplace_back([this] { run(); });
+    }
+
+    // The queued tasks are run before the workers exit.
+    ~thread_pool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      cond_.notify_all();
+      for (auto &t : workers_) t.join();
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    unsigned size() const { return unsigned(workers_.size()); }
+
+    void submit(std::function<void()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+      }
+      cond_.notify_one();
+    }
+
+  private:
+    void run()
+    {
+      for (;;) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+          if (tasks_.empty()) return;
+          task = std::move(tasks_.front());
+          tasks_.pop_front();
+        }
+        task();
+      }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()> > tasks_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+  };
+
+
+  // The pool shared by the sorts of the process
+  inline thread_pool &shared_pool()
+  {
+    static thread_pool pool;
+    return pool;
+  }
+
+
+  // Subranges shorter than this are not split into tasks.
+  const size_t parallel_task_size = size_t(1) << 15;
+
+  // A sort split into tasks.
+  // The future becomes ready when the last task finishes.
+  template<class RAIt, class Cmp, class Executor>
+  class parallel_sort_job : public std::enable_shared_from_this<parallel_sort_job<RAIt, Cmp, Executor> > {
+  public:
+    parallel_sort_job(Cmp cmp, Executor &executor)
+      : cmp_(cmp), executor_(executor), pending_(0) {}
+
+    std::future<void> future() { return done_.get_future(); }
+
+    // The task is counted before submit(), since it may finish before
+    // submit() returns; if submit() throws, the count is given back and
+    // the exception is rethrown.
+    void spawn(RAIt first, RAIt last, size_t s)
+    {
+      pending_++;
+      try {
+        auto self = this->shared_from_this();
+        uint64_t flow = QUICKSORT_MM_TRACE_SPAWN();
+        executor_.submit([self, first, last, s, flow] { self->run(first, last, s, flow); });
+      }
+      catch (...) {
+        pending_--;
+        throw;
+      }
+    }
+
+  private:
+    void run(RAIt first, RAIt last, size_t s, uint64_t flow)
+    {
+      QUICKSORT_MM_TRACE_START(flow);
+      QUICKSORT_MM_TRACE_BEGIN(task_begin);
+      size_t task_size = last - first;
+      try {
+        while (size_t(last - first) >= parallel_task_size) {
+          if (s < 10) s = 10;
+          QUICKSORT_MM_TRACE_BEGIN(pivot_begin);
+          auto pivot = rs3_5_2_pick_pivot(first, last, cmp_, s);
+          QUICKSORT_MM_TRACE_END("pivot", pivot_begin, last - first);
+          QUICKSORT_MM_TRACE_BEGIN(partition_begin);
+          auto pos = partition(first, last, pivot, cmp_);
+          QUICKSORT_MM_TRACE_END("partition", partition_begin, last - first);
+          s = s*12/17;
+          // Submit the shorter side, and continue with the longer one.
+          if (pos - first < last - pos) {
+            spawn(first, pos, s);
+            first = pos+1;
+          }
+          else {
+            spawn(pos+1, last, s);
+            last = pos;
+          }
+        }
+        QUICKSORT_MM_TRACE_BEGIN(leaf_begin);
+        quicksort_body(first, last, cmp_, s);
+        QUICKSORT_MM_TRACE_END("leaf", leaf_begin, last - first);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) error_ = std::current_exception();
+      }
+      QUICKSORT_MM_TRACE_END("task", task_begin, task_size);
+
+      if (--pending_ == 0) {
+        if (error_) done_.set_exception(error_);
+        else done_.set_value();
+      }
+    }
+
+    Cmp cmp_;
+    Executor &executor_;
+    std::atomic<size_t> pending_;
+    std::promise<void> done_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+  };
+
+
+  // ======================================================
+  // Asynchronous quicksort
+  // ======================================================
+  template<class RandomAccessIterator, class Compare, class Executor>
+  std::future<void> async_sort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp, Executor &executor)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    typedef decltype(to_less<T>(cmp)) less_type;
+    typedef parallel_sort_job<RandomAccessIterator, less_type, Executor> job_type;
+
+    auto job = std::make_shared<job_type>(to_less<T>(cmp), executor);
+    auto future = job->future();
+    job->spawn(first, last, approx_sqrt(last - first));
+    return future;
+  }
+
+  template<class RandomAccessIterator, class Compare>
+  std::future<void> async_sort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp)
+  {
+    return async_sort(first, last, cmp, shared_pool());
+  }
+
+  template<class RandomAccessIterator>
+  std::future<void> async_sort(RandomAccessIterator first, RandomAccessIterator last)
+  {
+    std::less<typename std::iterator_traits<RandomAccessIterator>::value_type> cmp;
+    return async_sort(first, last, cmp, shared_pool());
+  }
+}
+
+#endif
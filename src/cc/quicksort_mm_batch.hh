@@ -0,0 +1,142 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Batch of many independent sorts.
+//
+// The jobs (ptr, n, cmp) are queued by add() and sorted by run():
+// * the jobs of parallel_task_size or more elements are split into
+//   tasks on the pool, as async_sort;
+// * the smaller ones are grouped into a batch per thread, balanced by
+//   the cost n log n (the longest job first to the least loaded
+//   batch), and each batch is sorted by a single task.
+// The calling thread sorts one of the batches itself.
+// ======================================================
+
+#ifndef QUICKSORT_MM_BATCH_HH_INCLUDED
+#define QUICKSORT_MM_BATCH_HH_INCLUDED
+
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include "quicksort_mm.hh"
+#include "quicksort_mm_async.hh"
+
+namespace quicksort_mm {
+  template<class T, class Compare = std::less<T> >
+  class batch {
+  public:
+    struct job {
+      T *data;
+      size_t size;
+      Compare cmp;
+    };
+
+    explicit batch(thread_pool &pool = shared_pool()) : pool_(pool) {}
+
+    void add(T *data, size_t size, Compare cmp = Compare())
+    {
+      jobs_.push_back(job{data, size, cmp});
+    }
+
+    size_t size() const { return jobs_.size(); }
+
+    // Sort all the queued jobs and wait for them; the queue is emptied.
+    // The first exception from a comparator is rethrown.
+    // This must not be called from a worker of the pool.
+    void run()
+    {
+      std::vector<job> jobs;
+      jobs.swap(jobs_);
+
+      // There is a future per large job or per group of small ones, and
+      // reserving them keeps push_back from losing one that is running.
+      std::vector<std::future<void> > futures;
+      futures.reserve(jobs.size());
+      std::vector<std::vector<job> > groups;
+      std::exception_ptr error;
+      // If a submission throws, the tasks already queued are still
+      // waited for below, since they refer to the jobs and the groups.
+      // A task whose submission failed breaks its promise.
+      try {
+        std::vector<job> small;
+        for (auto &j : jobs) {
+          if (j.size >= parallel_task_size) {
+            futures.push_back(async_sort(j.data, j.data + j.size, j.cmp, pool_));
+          }
+          else if (j.size > 1) {
+            small.push_back(j);
+          }
+        }
+
+        groups = make_groups(small);
+        for (size_t g = 1; g < groups.size(); g++) {
+          auto task = std::make_shared<std::packaged_task<void()> >(
+            [g, &groups] { sort_group(groups[g]); });
+          futures.push_back(task->get_future());
+          pool_.submit([task] { (*task)(); });
+        }
+
+        if (!groups.empty()) sort_group(groups[0]);
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      // Wait for all the tasks, since they refer to the jobs.
+      for (auto &f : futures) {
+        try {
+          f.get();
+        }
+        catch (...) {
+          if (!error) error = std::current_exception();
+        }
+      }
+      if (error) std::rethrow_exception(error);
+    }
+
+  private:
+    // Split the jobs into a batch per thread (including the caller).
+    std::vector<std::vector<job> > make_groups(std::vector<job> &jobs) const
+    {
+      size_t ngroups = pool_.size() + 1;
+      if (ngroups > jobs.size()) ngroups = jobs.size();
+      std::vector<std::vector<job> > groups(ngroups);
+      std::vector<double> load(ngroups, 0.0);
+
+      quicksort(jobs.begin(), jobs.end(), [](const job &a, const job &b) { return a.size > b.size; });
+      for (auto &j : jobs) {
+        size_t g = 0;
+        for (size_t i = 1; i < ngroups; i++) {
+          if (load[i] < load[g]) g = i;
+        }
+        groups[g].push_back(j);
+        load[g] += double(j.size) * std::log2(double(j.size));
+      }
+      return groups;
+    }
+
+    static void sort_group(std::vector<job> &group)
+    {
+      QUICKSORT_MM_TRACE_BEGIN(group_begin);
+      size_t n = 0;
+      for (auto &j : group) {
+        quicksort(j.data, j.data + j.size, j.cmp);
+        n += j.size;
+      }
+      QUICKSORT_MM_TRACE_END("group", group_begin, n);
+    }
+
+    thread_pool &pool_;
+    std::vector<job> jobs_;
+  };
+}
+
+#endif
@@ -0,0 +1,229 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Sorting a virtual concatenation of separately allocated buffers.
+//
+// chunked_view<T> presents the buffers (ptr, len) as one random
+// access sequence without copying them. Its iterator is segmented
+// (see segmented_iterator_traits), so that the partition runs on raw
+// pointers within each buffer.
+//
+// Requires C++17.
+// ======================================================
+
+#ifndef QUICKSORT_MM_CHUNKED_HH_INCLUDED
+#define QUICKSORT_MM_CHUNKED_HH_INCLUDED
+
+#if __cplusplus < 201703L
+#error "quicksort_mm_chunked.hh requires C++17"
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  template<class T>
+  struct chunk {
+    T *data;
+    size_t size;
+  };
+
+  template<class T>
+  class chunked_iterator;
+
+
+  template<class T>
+  class chunked_view {
+  public:
+    typedef chunked_iterator<T> iterator;
+
+    // Empty buffers are dropped here, so that every chunk has an element.
+    explicit chunked_view(const std::vector<chunk<T> > &chunks)
+      : size_(0)
+    {
+      for (auto &c : chunks) {
+        if (c.size == 0) continue;
+        chunks_.push_back(c);
+        offsets_.push_back(size_);
+        size_ += c.size;
+      }
+    }
+
+    size_t size() const { return size_; }
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size_); }
+
+  private:
+    // Index of the chunk containing the i-th element.
+    // The end position belongs to the last chunk.
+    size_t find_chunk(size_t i) const
+    {
+      return std::upper_bound(offsets_.begin(), offsets_.end(), i) - offsets_.begin() - 1;
+    }
+
+    std::vector<chunk<T> > chunks_;
+    std::vector<size_t> offsets_;
+    size_t size_;
+
+    friend class chunked_iterator<T>;
+  };
+
+
+  template<class T>
+  class chunked_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_cv<T>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+
+    chunked_iterator() : view_(nullptr), i_(0), c_(0) {}
+
+    reference operator*() const { return *local(); }
+    pointer operator->() const { return local(); }
+    reference operator[](difference_type d) const { return *(*this + d); }
+
+    chunked_iterator &operator+=(difference_type d)
+    {
+      i_ += d;
+      // Look up the chunk only when leaving the current one.
+      const auto &v = *view_;
+      if (i_ < v.offsets_[c_] || (i_ >= v.offsets_[c_] + v.chunks_[c_].size && c_+1 < v.chunks_.size())) {
+        c_ = v.find_chunk(i_);
+      }
+      return *this;
+    }
+    chunked_iterator &operator-=(difference_type d) { return *this += -d; }
+    chunked_iterator &operator++() { return *this += 1; }
+    chunked_iterator &operator--() { return *this -= 1; }
+    chunked_iterator operator++(int) { auto t = *this; *this += 1; return t; }
+    chunked_iterator operator--(int) { auto t = *this; *this -= 1; return t; }
+
+    friend chunked_iterator operator+(chunked_iterator it, difference_type d) { return it += d; }
+    friend chunked_iterator operator+(difference_type d, chunked_iterator it) { return it += d; }
+    friend chunked_iterator operator-(chunked_iterator it, difference_type d) { return it -= d; }
+    friend difference_type operator-(const chunked_iterator &a, const chunked_iterator &b)
+    {
+      return difference_type(a.i_) - difference_type(b.i_);
+    }
+
+    friend bool operator==(const chunked_iterator &a, const chunked_iterator &b) { return a.i_ == b.i_; }
+    friend bool operator!=(const chunked_iterator &a, const chunked_iterator &b) { return a.i_ != b.i_; }
+    friend bool operator<(const chunked_iterator &a, const chunked_iterator &b) { return a.i_ < b.i_; }
+    friend bool operator>(const chunked_iterator &a, const chunked_iterator &b) { return a.i_ > b.i_; }
+    friend bool operator<=(const chunked_iterator &a, const chunked_iterator &b) { return a.i_ <= b.i_; }
+    friend bool operator>=(const chunked_iterator &a, const chunked_iterator &b) { return a.i_ >= b.i_; }
+
+    // For segmented_iterator_traits.
+    // The pointers are null for an empty view.
+    pointer local() const
+    {
+      if (view_->chunks_.empty()) return nullptr;
+      return view_->chunks_[c_].data + (i_ - view_->offsets_[c_]);
+    }
+    pointer segment_begin() const
+    {
+      if (view_->chunks_.empty()) return nullptr;
+      return view_->chunks_[c_].data;
+    }
+    pointer segment_end() const
+    {
+      if (view_->chunks_.empty()) return nullptr;
+      return view_->chunks_[c_].data + view_->chunks_[c_].size;
+    }
+
+  private:
+    chunked_iterator(const chunked_view<T> *view, size_t i)
+      : view_(view), i_(i), c_(view->chunks_.empty() ? 0 : view->find_chunk(i)) {}
+
+    const chunked_view<T> *view_;
+    size_t i_;   // position in the whole sequence
+    size_t c_;   // chunk containing i_
+
+    friend class chunked_view<T>;
+  };
+
+
+  template<class T>
+  struct segmented_iterator_traits<chunked_iterator<T> > {
+    typedef T *pointer;
+
+    static constexpr bool is_segmented = true;
+    static pointer local(const chunked_iterator<T> &it) { return it.local(); }
+    static pointer segment_begin(const chunked_iterator<T> &it) { return it.segment_begin(); }
+    static pointer segment_end(const chunked_iterator<T> &it) { return it.segment_end(); }
+  };
+
+
+  // ======================================================
+  // Sort the buffers in place as one logical array.
+  // ======================================================
+  template<class T, class Compare>
+  void quicksort_chunks(const std::vector<chunk<T> > &chunks, Compare cmp)
+  {
+    chunked_view<T> view(chunks);
+    quicksort(view.begin(), view.end(), cmp);
+  }
+
+  template<class T>
+  void quicksort_chunks(const std::vector<chunk<T> > &chunks)
+  {
+    quicksort_chunks(chunks, std::less<typename std::remove_cv<T>::type>());
+  }
+
+
+  // ======================================================
+  // Sort each buffer in place, and merge them into out.
+  // The input buffers are modified (each is left sorted); the vector
+  // is const only because the (ptr, len) entries are not changed.
+  // out must have room for all the elements, and must not overlap them.
+  // ======================================================
+  template<class T, class OutputIterator, class Compare>
+  OutputIterator sort_chunks_into(const std::vector<chunk<T> > &chunks, OutputIterator out, Compare cmp)
+  {
+    std::vector<chunk<T> > rest;
+    for (auto &c : chunks) {
+      if (c.size == 0) continue;
+      quicksort(c.data, c.data + c.size, cmp);
+      rest.push_back(c);
+    }
+
+    // K-way merge by a heap whose top is the chunk with the smallest head.
+    auto less = to_less<typename std::remove_cv<T>::type>(cmp);
+    auto heap_cmp = [&less](const chunk<T> &a, const chunk<T> &b) { return less(*b.data, *a.data); };
+    std::make_heap(rest.begin(), rest.end(), heap_cmp);
+    while (!rest.empty()) {
+      std::pop_heap(rest.begin(), rest.end(), heap_cmp);
+      auto &c = rest.back();
+      *out++ = *c.data;
+      c.data++;
+      c.size--;
+      if (c.size == 0) {
+        rest.pop_back();
+      }
+      else {
+        std::push_heap(rest.begin(), rest.end(), heap_cmp);
+      }
+    }
+    return out;
+  }
+
+  template<class T, class OutputIterator>
+  OutputIterator sort_chunks_into(const std::vector<chunk<T> > &chunks, OutputIterator out)
+  {
+    return sort_chunks_into(chunks, out, std::less<typename std::remove_cv<T>::type>());
+  }
+}
+
+#endif
@@ -0,0 +1,106 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Eytzinger (BFS) layout of a sorted array and its search.
+//
+// After sorting, the array is copied into the layout where the node i
+// has the children 2i and 2i+1 (1-based). The search descends the
+// layout without branches, and the nodes a few levels below are
+// prefetched, since they lie in a single cache line.
+//
+// The layout is filled in O(N) by the in-order traversal of the tree.
+// ======================================================
+
+#ifndef QUICKSORT_MM_EYTZINGER_HH_INCLUDED
+#define QUICKSORT_MM_EYTZINGER_HH_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  // Copy the sorted first[i], first[i+1], ... to the subtree of the node k.
+  // The index of the next element to be copied is returned.
+  template<class RandomAccessIterator, class T>
+  size_t eytzinger_fill(RandomAccessIterator first, size_t i, T *nodes, size_t n, size_t k)
+  {
+    if (k > n) return i;
+    i = eytzinger_fill(first, i, nodes, n, 2*k);
+    nodes[k] = first[i++];
+    return eytzinger_fill(first, i, nodes, n, 2*k+1);
+  }
+
+
+  // Compare may be a three-way comparator as in quicksort.
+  template<class T, class Compare = std::less<T> >
+  class eytzinger {
+    typedef decltype(to_less<T>(std::declval<Compare>())) less_type;
+
+  public:
+    // Build from a sorted range.
+    template<class RandomAccessIterator>
+    eytzinger(RandomAccessIterator first, RandomAccessIterator last, Compare cmp = Compare())
+      : n_(last - first), nodes_(n_ + 1), less_(to_less<T>(cmp))
+    {
+      eytzinger_fill(first, 0, nodes_.data(), n_, 1);
+    }
+
+    size_t size() const { return n_; }
+
+    // The node k (1-based); nodes 2k and 2k+1 are its children.
+    const T &node(size_t k) const { return nodes_[k]; }
+
+    // Find the first node not less than x, as std::lower_bound.
+    // The node index is returned, or 0 if every node is less than x.
+    size_t lower_bound(const T &x) const
+    {
+      // The descendants of k at a few levels below lie in one cache line.
+      const size_t stride = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+      const T *b = nodes_.data();
+      size_t k = 1;
+      while (k <= n_) {
+#if defined(__GNUC__)
+        __builtin_prefetch(b + stride*k);
+#endif
+        k = 2*k + (less_(b[k], x) ? 1 : 0);
+      }
+      // Cancel the right turns after the last left turn.
+      while (k & 1) k >>= 1;
+      return k >> 1;
+    }
+
+  private:
+    size_t n_;
+    std::vector<T> nodes_;  // nodes_[0] is unused
+    less_type less_;
+  };
+
+
+  // Sort [first, last) and build the Eytzinger layout of it.
+  template<class RandomAccessIterator, class Compare>
+  eytzinger<typename std::iterator_traits<RandomAccessIterator>::value_type, Compare>
+  sort_eytzinger(RandomAccessIterator first, RandomAccessIterator last, Compare cmp)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    quicksort(first, last, cmp);
+    return eytzinger<T, Compare>(first, last, cmp);
+  }
+
+  template<class RandomAccessIterator>
+  eytzinger<typename std::iterator_traits<RandomAccessIterator>::value_type>
+  sort_eytzinger(RandomAccessIterator first, RandomAccessIterator last)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    return sort_eytzinger(first, last, std::less<T>());
+  }
+}
+
+#endif
@@ -0,0 +1,151 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Quicksort with warm pivot hints.
+//
+// pivot_hint keeps the splitters of the last sort: the values at the
+// quantiles 1/(m+1), ..., m/(m+1), read from the sorted array for
+// free. The next sort partitions by these values directly, the middle
+// one first, without sampling by rs3_5_2_pick_pivot. If a split is
+// off its expected position by more than 1/8 of the subrange, the hint
+// is stale there, and the subrange is sorted by quicksort_body (median
+// of medians). Even then, the waste is a single pass of partition, so
+// the worst case stays O(N log N).
+//
+// It pays when the arrays of the same distribution are sorted
+// repeatedly. A hint must not be shared by concurrent sorts.
+// ======================================================
+
+#ifndef QUICKSORT_MM_HINT_HH_INCLUDED
+#define QUICKSORT_MM_HINT_HH_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  // Move the elements less than v to the front, as std::partition.
+  // The first element not less than v is returned.
+  template<class RandomAccessIterator, class T, class Compare>
+  RandomAccessIterator partition_by_value(RandomAccessIterator first, RandomAccessIterator last, const T &v, Compare cmp)
+  {
+    for (;;) {
+      while (first != last && cmp(*first, v)) ++first;
+      do {
+        if (first == last) return first;
+        --last;
+      } while (!cmp(*last, v));
+      std::swap(*first, *last);
+      ++first;
+    }
+  }
+
+
+  // Sort [first, last) by the splitters sp[lo], ..., sp[hi-1],
+  // which are expected at the quantiles 1/(hi-lo+1), ... of the range.
+  template<class RandomAccessIterator, class T, class Compare>
+  void hinted_quicksort_body(RandomAccessIterator first, RandomAccessIterator last, Compare cmp,
+                             const std::vector<T> &sp, size_t lo, size_t hi, size_t &hits, size_t &misses)
+  {
+    size_t nelem = last - first;
+    if (lo == hi || nelem < 16) {
+      quicksort_body(first, last, cmp, approx_sqrt(nelem));
+      return;
+    }
+
+    size_t mid = lo + (hi-lo)/2;
+    auto pos = partition_by_value(first, last, sp[mid], cmp);
+    size_t expected = nelem * (mid-lo+1) / (hi-lo+1);
+    size_t actual = pos - first;
+    size_t error = actual < expected ? expected - actual : actual - expected;
+    if (error > nelem/8) {
+      // Stale
+      misses++;
+      quicksort_body(first, pos, cmp, approx_sqrt(actual));
+      quicksort_body(pos, last, cmp, approx_sqrt(nelem - actual));
+      return;
+    }
+    hits++;
+    hinted_quicksort_body(first, pos, cmp, sp, lo, mid, hits, misses);
+    hinted_quicksort_body(pos, last, cmp, sp, mid+1, hi, hits, misses);
+  }
+
+
+  template<class T>
+  class pivot_hint {
+  public:
+    // Arrays shorter than this are sorted without the hint.
+    static const size_t min_size = 4096;
+
+    explicit pivot_hint(size_t nsplitters = 15) : nsplitters_(nsplitters), hits_(0), misses_(0) {}
+
+    bool empty() const { return splitters_.empty(); }
+    void clear() { splitters_.clear(); }
+
+    const std::vector<T> &splitters() const { return splitters_; }
+
+    // Numbers of the splitters accepted and rejected as stale
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+    // Record the splitters of the sorted range.
+    template<class RandomAccessIterator>
+    void record(RandomAccessIterator first, RandomAccessIterator last)
+    {
+      size_t nelem = last - first;
+      splitters_.clear();
+      if (nelem < min_size) return;
+      for (size_t i = 1; i <= nsplitters_; i++) {
+        splitters_.push_back(first[nelem * i / (nsplitters_+1)]);
+      }
+    }
+
+    // Sort [first, last) using the splitters, and refresh them.
+    template<class RandomAccessIterator, class Compare>
+    void sort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp)
+    {
+      size_t nelem = last - first;
+      if (splitters_.empty() || nelem < min_size) {
+        quicksort_body(first, last, cmp, approx_sqrt(nelem));
+      }
+      else {
+        hinted_quicksort_body(first, last, cmp, splitters_, 0, splitters_.size(), hits_, misses_);
+      }
+      record(first, last);
+    }
+
+  private:
+    size_t nsplitters_;
+    std::vector<T> splitters_;
+    size_t hits_, misses_;
+  };
+
+
+  // Quicksort with a pivot hint.
+  // The hint is used if not empty, and then refreshed from the result.
+  template<class RandomAccessIterator, class Compare>
+  void quicksort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp,
+                 pivot_hint<typename std::iterator_traits<RandomAccessIterator>::value_type> &hint)
+  {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    hint.sort(first, last, to_less<T>(cmp));
+  }
+
+  template<class RandomAccessIterator>
+  void quicksort(RandomAccessIterator first, RandomAccessIterator last,
+                 pivot_hint<typename std::iterator_traits<RandomAccessIterator>::value_type> &hint)
+  {
+    std::less<typename std::iterator_traits<RandomAccessIterator>::value_type> cmp;
+    quicksort(first, last, cmp, hint);
+  }
+}
+
+#endif
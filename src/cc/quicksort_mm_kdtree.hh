@@ -0,0 +1,171 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Balanced k-d tree built by quickselect with median of medians.
+//
+// Each node splits its range at the median of the coordinate
+// (depth % dims), which is found by quickselect. Since the selection
+// is linear in the worst case, the build is O(N log N) in the worst
+// case and the tree is perfectly balanced.
+//
+// The tree has the implicit layout: the subtree over [lo, hi) has its
+// root at lo + (hi-lo)/2, the left subtree over [lo, root) and the
+// right subtree over [root+1, hi). The coordinates are stored in this
+// order as structure of arrays.
+//
+// The splits run in place on the structure of arrays: a point is
+// swapped with all of its coordinates and its index, and the selection
+// reads the coordinate of the split contiguously.
+// ======================================================
+
+#ifndef QUICKSORT_MM_KDTREE_HH_INCLUDED
+#define QUICKSORT_MM_KDTREE_HH_INCLUDED
+
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  template<class T>
+  struct kdtree {
+    size_t n;
+    size_t dims;
+    // coords[d*n + i] is the d-th coordinate of the i-th node.
+    std::vector<T> coords;
+    // index[i] is the position of the i-th node in the input.
+    std::vector<size_t> index;
+
+    const T *coord(size_t d) const { return coords.data() + d*n; }
+
+    static size_t root(size_t lo, size_t hi) { return lo + (hi-lo)/2; }
+  };
+
+
+  // The arrays of the tree under construction
+  template<class T>
+  struct kdtree_arrays {
+    T *coords;
+    size_t *index;
+    size_t n, dims;
+  };
+
+  // The i-th point of the arrays, as the reference of kdtree_iterator
+  template<class T>
+  struct kdtree_point {
+    const kdtree_arrays<T> *a;
+    size_t i;
+  };
+
+  // Swap the two points with all the coordinates and the indices.
+  template<class T>
+  void swap(kdtree_point<T> p, kdtree_point<T> q)
+  {
+    const kdtree_arrays<T> &a = *p.a;
+    for (size_t d = 0; d < a.dims; d++) std::swap(a.coords[d*a.n + p.i], a.coords[d*a.n + q.i]);
+    std::swap(a.index[p.i], a.index[q.i]);
+  }
+
+  // The iterator over the points, returning the proxies
+  template<class T>
+  class kdtree_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef kdtree_point<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef void pointer;
+    typedef kdtree_point<T> reference;
+
+    kdtree_iterator(const kdtree_arrays<T> *a, size_t i) : a_(a), i_(i) {}
+
+    reference operator*() const { return reference{a_, i_}; }
+    reference operator[](difference_type k) const { return reference{a_, i_ + k}; }
+
+    kdtree_iterator &operator++() { i_++; return *this; }
+    kdtree_iterator &operator--() { i_--; return *this; }
+    kdtree_iterator operator++(int) { kdtree_iterator it = *this; i_++; return it; }
+    kdtree_iterator operator--(int) { kdtree_iterator it = *this; i_--; return it; }
+    kdtree_iterator &operator+=(difference_type k) { i_ += k; return *this; }
+    kdtree_iterator &operator-=(difference_type k) { i_ -= k; return *this; }
+    kdtree_iterator operator+(difference_type k) const { return kdtree_iterator(a_, i_ + k); }
+    kdtree_iterator operator-(difference_type k) const { return kdtree_iterator(a_, i_ - k); }
+    difference_type operator-(const kdtree_iterator &it) const { return difference_type(i_ - it.i_); }
+
+    bool operator==(const kdtree_iterator &it) const { return i_ == it.i_; }
+    bool operator!=(const kdtree_iterator &it) const { return i_ != it.i_; }
+    bool operator<(const kdtree_iterator &it) const { return i_ < it.i_; }
+    bool operator>(const kdtree_iterator &it) const { return i_ > it.i_; }
+    bool operator<=(const kdtree_iterator &it) const { return i_ <= it.i_; }
+    bool operator>=(const kdtree_iterator &it) const { return i_ >= it.i_; }
+
+  private:
+    const kdtree_arrays<T> *a_;
+    size_t i_;
+  };
+
+
+  // Split [lo, hi) of the points recursively.
+  // The subtrees are built by separate threads while threads > 1.
+  // If a split throws, the thread of its sibling is joined (by the
+  // destructor of the future) before the exception leaves.
+  template<class T>
+  void kdtree_split(const kdtree_arrays<T> *a, size_t lo, size_t hi, size_t depth, unsigned threads)
+  {
+    kdtree_iterator<T> first(a, 0);
+    while (hi - lo > 1) {
+      size_t m = kdtree<T>::root(lo, hi);
+      const T *x = a->coords + (depth % a->dims)*a->n;
+      quickselect(first+lo, first+m, first+hi, [x](kdtree_point<T> p, kdtree_point<T> q) { return x[p.i] < x[q.i]; });
+
+      depth++;
+      // Small subtrees are not worth a thread.
+      if (threads > 1 && hi - lo >= (1 << 14)) {
+        auto left = std::async(std::launch::async, kdtree_split<T>, a, lo, m, depth, threads/2);
+        kdtree_split(a, m+1, hi, depth, threads - threads/2);
+        left.get();
+        return;
+      }
+      // The right subtree is handled by the loop.
+      kdtree_split(a, lo, m, depth, 1);
+      lo = m+1;
+    }
+  }
+
+
+  // ======================================================
+  // Build a k-d tree of n points of dims coordinates.
+  //
+  // points:  the coordinates in row-major order (points[i*dims + d]).
+  // threads: number of threads for the subtree construction.
+  // ======================================================
+  template<class T>
+  kdtree<T> build_kdtree(const T *points, size_t n, size_t dims, unsigned threads = 1)
+  {
+    kdtree<T> tree;
+    tree.n = n;
+    tree.dims = dims;
+    if (n == 0 || dims == 0) return tree;
+
+    // Structure of arrays of the input, split into the tree order in place
+    tree.coords.resize(n*dims);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t d = 0; d < dims; d++) tree.coords[d*n + i] = points[i*dims + d];
+    }
+
+    tree.index.resize(n);
+    for (size_t i = 0; i < n; i++) tree.index[i] = i;
+    if (threads == 0) threads = 1;
+    kdtree_arrays<T> a = {tree.coords.data(), tree.index.data(), n, dims};
+    kdtree_split(&a, 0, n, 0, threads);
+    return tree;
+  }
+}
+
+#endif
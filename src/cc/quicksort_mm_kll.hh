@@ -0,0 +1,256 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Streaming quantiles by the KLL sketch[1].
+//
+// The items are kept in compactors of levels h = 0, 1, ...; an item
+// of the level h stands for 2^h items of the stream. When a compactor
+// is full, it is sorted by quicksort and every other item (the odd or
+// even ones at random) is promoted to the next level. The capacity of
+// the level h is k (2/3)^(H-1-h) for the top level H-1, so that the
+// memory is O(k + log N) and the rank error is about 1.7/k.
+//
+// Sketches are mergeable: e.g. a sketch per thread is kept on the
+// ingestion path and they are merged at the query time.
+//
+// [1] Z. Karnin, K. Lang, E. Liberty, FOCS 2016, 71 (2016).
+// ======================================================
+
+#ifndef QUICKSORT_MM_KLL_HH_INCLUDED
+#define QUICKSORT_MM_KLL_HH_INCLUDED
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  // The parameter k for the rank error eps
+  inline size_t kll_k_for_error(double eps)
+  {
+    double k = std::ceil(1.7 / eps);
+    return k < 8 ? 8 : size_t(k);
+  }
+
+
+  template<class T, class Compare = std::less<T> >
+  class kll_sketch {
+  public:
+    explicit kll_sketch(size_t k = 200, Compare cmp = Compare())
+      : k_(k < 8 ? 8 : k), n_(0), size_(0), capacity_(0), cmp_(cmp), rng_(0x9e3779b97f4a7c15ull)
+    {
+      resize_levels(1);
+    }
+
+    size_t k() const { return k_; }
+    uint64_t count() const { return n_; }
+    bool empty() const { return n_ == 0; }
+
+    void update(const T &x)
+    {
+      levels_[0].push_back(x);
+      size_++;
+      n_++;
+      while (size_ >= capacity_) compress();
+    }
+
+    void merge(const kll_sketch &other)
+    {
+      // The levels of other would be inserted into themselves.
+      if (&other == this) {
+        kll_sketch copy(other);
+        merge(copy);
+        return;
+      }
+      if (other.levels_.size() > levels_.size()) resize_levels(other.levels_.size());
+      for (size_t h = 0; h < other.levels_.size(); h++) {
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+      }
+      size_ += other.size_;
+      n_ += other.n_;
+      while (size_ >= capacity_) compress();
+    }
+
+    // Estimated number of the items less than x.
+    uint64_t rank(const T &x) const
+    {
+      uint64_t r = 0;
+      for (size_t h = 0; h < levels_.size(); h++) {
+        for (auto &y : levels_[h]) {
+          if (cmp_(y, x)) r += uint64_t(1) << h;
+        }
+      }
+      return r;
+    }
+
+    // Estimated q-quantile (0 <= q <= 1).
+    // The sketch must not be empty.
+    T quantile(double q) const
+    {
+      auto items = weighted_items();
+      if (items.empty()) throw std::out_of_range("kll_sketch::quantile: empty sketch");
+
+      uint64_t total = 0;
+      for (auto &it : items) total += it.second;
+      double target = q * double(total);
+      uint64_t cum = 0;
+      for (auto &it : items) {
+        cum += it.second;
+        if (double(cum) > target) return it.first;
+      }
+      return items.back().first;
+    }
+
+    // ======================================================
+    // Serialization
+    //
+    // Layout (native byte order):
+    //   uint64 k, n, number of levels, size of each level,
+    //   then the items of the levels 0, 1, ...
+    // ======================================================
+    std::vector<unsigned char> serialize() const
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "serialization needs trivially copyable items");
+      std::vector<unsigned char> out;
+      put(out, k_);
+      put(out, n_);
+      put(out, levels_.size());
+      for (auto &level : levels_) put(out, level.size());
+      for (auto &level : levels_) {
+        size_t bytes = level.size() * sizeof(T);
+        size_t pos = out.size();
+        out.resize(pos + bytes);
+        if (bytes) std::memcpy(&out[pos], level.data(), bytes);
+      }
+      return out;
+    }
+
+    static kll_sketch deserialize(const unsigned char *p, size_t len, Compare cmp = Compare())
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "serialization needs trivially copyable items");
+      const unsigned char *end = p + len;
+      kll_sketch s(size_t(get(p, end)), cmp);
+      s.n_ = get(p, end);
+      uint64_t nlevels = get(p, end);
+      if (nlevels == 0 || nlevels > 64) throw std::invalid_argument("kll_sketch::deserialize: broken data");
+      s.resize_levels(size_t(nlevels));
+      for (auto &level : s.levels_) {
+        uint64_t size = get(p, end);
+        if (size > uint64_t(end - p) / sizeof(T)) throw std::invalid_argument("kll_sketch::deserialize: broken data");
+        level.resize(size_t(size));
+      }
+      for (auto &level : s.levels_) {
+        size_t bytes = level.size() * sizeof(T);
+        if (size_t(end - p) < bytes) throw std::invalid_argument("kll_sketch::deserialize: broken data");
+        if (bytes) std::memcpy(level.data(), p, bytes);
+        p += bytes;
+        s.size_ += level.size();
+      }
+      return s;
+    }
+
+  private:
+    // Capacity of the level h
+    size_t capacity(size_t h) const { return capacities_[h]; }
+
+    // The capacities depend on the depth below the top level, so they
+    // are computed again only when the number of levels changes.
+    void resize_levels(size_t nlevels)
+    {
+      levels_.resize(nlevels);
+      capacities_.resize(nlevels);
+      capacity_ = 0;
+      double scale = 1.0;
+      for (size_t h = nlevels; h-- > 0; scale *= 2.0/3.0) {
+        size_t c = size_t(std::ceil(double(k_) * scale));
+        capacities_[h] = c < 2 ? 2 : c;
+        capacity_ += capacities_[h];
+      }
+    }
+
+    // Compact the lowest full level.
+    // Since the total size reaches the total capacity, there is one.
+    void compress()
+    {
+      for (size_t h = 0; h < levels_.size(); h++) {
+        if (levels_[h].size() < capacity(h)) continue;
+        if (h+1 == levels_.size()) resize_levels(h+2);
+
+        auto &level = levels_[h];
+        quicksort(level.begin(), level.end(), cmp_);
+
+        // An odd item is left in the level.
+        size_t m = level.size() & ~size_t(1);
+        size_t offset = random_bit();
+        auto &next = levels_[h+1];
+        for (size_t i = offset; i < m; i += 2) next.push_back(level[i]);
+        level.erase(level.begin(), level.begin() + m);
+        size_ -= m/2;
+        return;
+      }
+    }
+
+    // Items with their weights, sorted by the items
+    std::vector<std::pair<T, uint64_t> > weighted_items() const
+    {
+      std::vector<std::pair<T, uint64_t> > items;
+      items.reserve(size_);
+      for (size_t h = 0; h < levels_.size(); h++) {
+        for (auto &y : levels_[h]) items.emplace_back(y, uint64_t(1) << h);
+      }
+      Compare cmp = cmp_;
+      quicksort(items.begin(), items.end(),
+                [&cmp](const std::pair<T, uint64_t> &a, const std::pair<T, uint64_t> &b) {
+                  return cmp(a.first, b.first);
+                });
+      return items;
+    }
+
+    // xorshift64
+    size_t random_bit()
+    {
+      rng_ ^= rng_ << 13;
+      rng_ ^= rng_ >> 7;
+      rng_ ^= rng_ << 17;
+      return size_t(rng_ >> 63);
+    }
+
+    static void put(std::vector<unsigned char> &out, uint64_t v)
+    {
+      unsigned char b[sizeof v];
+      std::memcpy(b, &v, sizeof v);
+      out.insert(out.end(), b, b + sizeof v);
+    }
+
+    static uint64_t get(const unsigned char *&p, const unsigned char *end)
+    {
+      uint64_t v;
+      if (size_t(end - p) < sizeof v) throw std::invalid_argument("kll_sketch::deserialize: broken data");
+      std::memcpy(&v, p, sizeof v);
+      p += sizeof v;
+      return v;
+    }
+
+    size_t k_;
+    uint64_t n_;
+    size_t size_;      // number of the items kept
+    size_t capacity_;  // sum of the capacities of the levels
+    Compare cmp_;
+    uint64_t rng_;
+    std::vector<std::vector<T> > levels_;
+    std::vector<size_t> capacities_;  // capacity of each level
+  };
+}
+
+#endif
@@ -0,0 +1,165 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Resumable quicksort for event-loop threads.
+//
+// resumable_sort keeps its own stack of the pending subranges
+// (first, last, thinning) instead of the recursion, and the partition
+// in progress can be suspended, so that the sort advances in slices
+// of a given time:
+//
+//   quicksort_mm::resumable_sort<It> sorter(first, last);
+//   while (!sorter.step(std::chrono::microseconds(500))) {
+//     // serve other events
+//   }
+//
+// The subranges shorter than leaf_size are sorted at once.
+// ======================================================
+
+#ifndef QUICKSORT_MM_RESUMABLE_HH_INCLUDED
+#define QUICKSORT_MM_RESUMABLE_HH_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  template<class RandomAccessIterator,
+           class Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type> >
+  class resumable_sort {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    typedef decltype(to_less<value_type>(std::declval<Compare>())) less_type;
+
+  public:
+    // Subranges shorter than this are sorted without suspension.
+    static const size_t leaf_size = 1024;
+    // Work (element visits) between the clock checks in step()
+    static const size_t work_quantum = 16384;
+
+    resumable_sort(RandomAccessIterator first, RandomAccessIterator last, Compare cmp = Compare())
+      : cmp_(to_less<value_type>(cmp)), partitioning_(false)
+    {
+      size_t nelem = last - first;
+      if (nelem > 1) stack_.push_back(range{first, last, approx_sqrt(nelem)});
+    }
+
+    bool done() const { return !partitioning_ && stack_.empty(); }
+
+    // Advance the sort for about the given time.
+    // It returns true when the sort is completed.
+    template<class Rep, class Period>
+    bool step(std::chrono::duration<Rep, Period> budget)
+    {
+      auto end = std::chrono::steady_clock::now() + budget;
+      while (!step_work(work_quantum)) {
+        if (std::chrono::steady_clock::now() >= end) return false;
+      }
+      return true;
+    }
+
+    // Advance the sort by about the given number of element visits.
+    // It returns true when the sort is completed.
+    bool step_work(size_t work)
+    {
+      while (work > 0) {
+        if (!partitioning_) {
+          if (stack_.empty()) return true;
+          cur_ = stack_.back();
+          stack_.pop_back();
+
+          size_t nelem = cur_.last - cur_.first;
+          if (cur_.s < 10) cur_.s = 10;
+          if (nelem < leaf_size) {
+            quicksort_body(cur_.first, cur_.last, cmp_, cur_.s);
+            // about N log2 N comparisons for N = leaf_size
+            work -= work < nelem*10 ? work : nelem*10;
+            continue;
+          }
+          start_partition();
+        }
+        if (partition_step(work)) finish_partition();
+      }
+      return done();
+    }
+
+  private:
+    struct range {
+      RandomAccessIterator first, last;
+      size_t s;
+    };
+
+    void start_partition()
+    {
+      auto pivot = rs3_5_2_pick_pivot(cur_.first, cur_.last, cmp_, cur_.s);
+      if (pivot != cur_.first) std::swap(*pivot, *cur_.first);
+      lo_ = cur_.first;
+      hi_ = cur_.last;
+      scanning_hi_ = true;
+      partitioning_ = true;
+    }
+
+    // Hoare's partition of cur_ around *cur_.first, suspended when the work runs out.
+    // It returns true when the partition is completed (lo_ == hi_).
+    bool partition_step(size_t &work)
+    {
+      auto pivot = cur_.first;
+      while (work > 0) {
+        if (scanning_hi_) {
+          for (;;) {
+            if (work == 0) return false;
+            work--;
+            hi_--;
+            if (lo_ == hi_) return true;
+            if (!cmp_(*pivot, *hi_)) break;
+          }
+          scanning_hi_ = false;
+        }
+        for (;;) {
+          if (work == 0) return false;
+          work--;
+          lo_++;
+          if (lo_ == hi_) return true;
+          if (!cmp_(*lo_, *pivot)) break;
+        }
+        std::swap(*lo_, *hi_);
+        scanning_hi_ = true;
+      }
+      return false;
+    }
+
+    // Put the pivot to its position and push the both sides.
+    // The shorter side is processed first, so that the stack is O(log N).
+    void finish_partition()
+    {
+      std::swap(*cur_.first, *lo_);
+      partitioning_ = false;
+
+      size_t s = cur_.s*12/17;
+      range left = {cur_.first, lo_, s};
+      range right = {lo_+1, cur_.last, s};
+      if (right.last - right.first < left.last - left.first) std::swap(left, right);
+      if (right.last - right.first > 1) stack_.push_back(right);
+      if (left.last - left.first > 1) stack_.push_back(left);
+    }
+
+    less_type cmp_;
+    std::vector<range> stack_;
+
+    // The partition in progress
+    bool partitioning_;
+    bool scanning_hi_;
+    range cur_;
+    RandomAccessIterator lo_, hi_;
+  };
+}
+
+#endif
@@ -0,0 +1,134 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Selection on strided data (e.g. a column of a row-major matrix).
+//
+// strided_iterator<T> walks the elements p[0], p[stride], ...,
+// so that the routines work on a column in place.
+//
+// select_columns() gets the k-th element of every column of a
+// row-major matrix. The columns are taken in blocks: the rows of the
+// block are copied into column buffers, so that each cache line of
+// the matrix is read once, and then each column buffer is selected.
+// ======================================================
+
+#ifndef QUICKSORT_MM_STRIDED_HH_INCLUDED
+#define QUICKSORT_MM_STRIDED_HH_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "quicksort_mm.hh"
+
+namespace quicksort_mm {
+  template<class T>
+  class strided_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_cv<T>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+
+    strided_iterator() : p_(nullptr), stride_(1) {}
+    strided_iterator(T *p, std::ptrdiff_t stride) : p_(p), stride_(stride) {}
+
+    reference operator*() const { return *p_; }
+    pointer operator->() const { return p_; }
+    reference operator[](difference_type d) const { return p_[d*stride_]; }
+
+    strided_iterator &operator+=(difference_type d) { p_ += d*stride_; return *this; }
+    strided_iterator &operator-=(difference_type d) { p_ -= d*stride_; return *this; }
+    strided_iterator &operator++() { p_ += stride_; return *this; }
+    strided_iterator &operator--() { p_ -= stride_; return *this; }
+    strided_iterator operator++(int) { auto t = *this; p_ += stride_; return t; }
+    strided_iterator operator--(int) { auto t = *this; p_ -= stride_; return t; }
+
+    friend strided_iterator operator+(strided_iterator it, difference_type d) { return it += d; }
+    friend strided_iterator operator+(difference_type d, strided_iterator it) { return it += d; }
+    friend strided_iterator operator-(strided_iterator it, difference_type d) { return it -= d; }
+    friend difference_type operator-(const strided_iterator &a, const strided_iterator &b)
+    {
+      return (a.p_ - b.p_) / a.stride_;
+    }
+
+    friend bool operator==(const strided_iterator &a, const strided_iterator &b) { return a.p_ == b.p_; }
+    friend bool operator!=(const strided_iterator &a, const strided_iterator &b) { return a.p_ != b.p_; }
+    friend bool operator<(const strided_iterator &a, const strided_iterator &b) { return a - b < 0; }
+    friend bool operator>(const strided_iterator &a, const strided_iterator &b) { return a - b > 0; }
+    friend bool operator<=(const strided_iterator &a, const strided_iterator &b) { return a - b <= 0; }
+    friend bool operator>=(const strided_iterator &a, const strided_iterator &b) { return a - b >= 0; }
+
+  private:
+    T *p_;
+    std::ptrdiff_t stride_;
+  };
+
+
+  // Quickselect on p[0], p[stride], ..., p[(n-1)*stride] in place.
+  template<class T, class Compare>
+  void quickselect_strided(T *p, size_t n, std::ptrdiff_t stride, size_t kth, Compare cmp)
+  {
+    strided_iterator<T> first(p, stride);
+    quickselect(first, first+kth, first+n, cmp);
+  }
+
+  template<class T>
+  void quickselect_strided(T *p, size_t n, std::ptrdiff_t stride, size_t kth)
+  {
+    quickselect_strided(p, n, stride, kth, std::less<T>());
+  }
+
+
+  // ======================================================
+  // The k-th element of each column of a row-major matrix
+  //
+  // a:     the matrix; the element (i, j) is a[i*ld + j].
+  // out:   receives the k-th element of each of the cols columns.
+  // block: number of columns taken at once. By default, a row of the
+  //        block fills a cache line of 64 bytes.
+  // The column buffers hold block*rows elements; a smaller block bounds
+  // the memory, at the cost of reading the matrix cols/block times.
+  // The matrix is not modified.
+  // ======================================================
+  template<class T, class OutputIterator, class Compare>
+  void select_columns(const T *a, size_t rows, size_t cols, size_t ld, size_t kth,
+                      OutputIterator out, Compare cmp, size_t block = 0)
+  {
+    if (rows <= kth) return;
+    if (block == 0) block = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+    if (block > cols) block = cols;
+
+    std::vector<T> buf(block * rows);
+    for (size_t j0 = 0; j0 < cols; j0 += block) {
+      size_t nb = cols - j0 < block ? cols - j0 : block;
+
+      // Copy the rows of the block into the column buffers buf[c*rows + i].
+      const T *src = a + j0;
+      for (size_t i = 0; i < rows; i++, src += ld) {
+        for (size_t c = 0; c < nb; c++) buf[c*rows + i] = src[c];
+      }
+
+      for (size_t c = 0; c < nb; c++) {
+        T *col = buf.data() + c*rows;
+        quickselect(col, col+kth, col+rows, cmp);
+        *out++ = col[kth];
+      }
+    }
+  }
+
+  template<class T, class OutputIterator>
+  void select_columns(const T *a, size_t rows, size_t cols, size_t ld, size_t kth, OutputIterator out)
+  {
+    select_columns(a, rows, cols, ld, kth, out, std::less<T>());
+  }
+}
+
+#endif
@@ -0,0 +1,217 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Timeline of the parallel sorts in the Chrome trace format.
+//
+// When compiled with QUICKSORT_MM_TRACE, the tasks of async_sort and
+// batch record spans (task, pivot, partition, leaf, group) with the
+// thread and the time. The hand-over of a task from the thread that
+// spawned it to the one that runs it is recorded as a flow (an arrow
+// in the viewer), and the gaps between the spans are the idle time.
+//
+// Each thread writes to its own ring buffer of ring_capacity events,
+// without locks; the oldest events are overwritten. The buffers are
+// read by write_chrome_trace(), which must be called when no sort is
+// running. The output is loaded by chrome://tracing or Perfetto.
+//
+//   quicksort_mm::trace::enable();
+//   quicksort_mm::async_sort(v.begin(), v.end()).get();
+//   quicksort_mm::trace::write_chrome_trace("sort.json");
+// ======================================================
+
+#ifndef QUICKSORT_MM_TRACE_HH_INCLUDED
+#define QUICKSORT_MM_TRACE_HH_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace quicksort_mm {
+  namespace trace {
+    // Events per thread; a power of 2
+    const size_t ring_capacity = size_t(1) << 16;
+
+    struct event {
+      const char *name;  // a string literal
+      char ph;           // 'X' span, 's'/'f' start/end of a flow
+      uint64_t ts;       // ns from the start of the process' trace
+      uint64_t dur;      // ns, for 'X'
+      uint64_t arg;      // elements for 'X', the flow id for 's'/'f'
+    };
+
+    // Written by a single thread, read after the writes.
+    class ring {
+    public:
+      explicit ring(unsigned tid) : tid_(tid), head_(0), events_(new event[ring_capacity]) {}
+
+      void push(const event &e)
+      {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        events_[h & (ring_capacity - 1)] = e;
+        head_.store(h + 1, std::memory_order_release);
+      }
+
+      unsigned tid() const { return tid_; }
+      uint64_t head() const { return head_.load(std::memory_order_acquire); }
+      const event &at(uint64_t i) const { return events_[i & (ring_capacity - 1)]; }
+      void clear() { head_.store(0, std::memory_order_relaxed); }
+
+    private:
+      unsigned tid_;
+      std::atomic<uint64_t> head_;
+      std::unique_ptr<event[]> events_;
+    };
+
+    // The rings of all the threads; never destroyed, so that the
+    // workers of a static pool may still record at the exit.
+    class registry {
+    public:
+      static registry &instance()
+      {
+        static registry *r = new registry;
+        return *r;
+      }
+
+      // The ring of the calling thread, created at its first event
+      ring &local()
+      {
+        thread_local ring *r = nullptr;
+        if (!r) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          rings_.emplace_back(new ring(unsigned(rings_.size()) + 1));
+          r = rings_.back().get();
+        }
+        return *r;
+      }
+
+      uint64_t now() const
+      {
+        auto d = std::chrono::steady_clock::now() - epoch_;
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+      }
+
+      std::atomic<bool> enabled;
+      std::atomic<uint64_t> next_flow;
+
+      std::vector<ring *> rings()
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<ring *> out;
+        for (auto &r : rings_) out.push_back(r.get());
+        return out;
+      }
+
+    private:
+      registry() : enabled(false), next_flow(1), epoch_(std::chrono::steady_clock::now()) {}
+
+      std::chrono::steady_clock::time_point epoch_;
+      std::mutex mutex_;
+      std::vector<std::unique_ptr<ring> > rings_;
+    };
+
+
+    // ======================================================
+    // Recording
+    // ======================================================
+    inline void enable() { registry::instance().enabled.store(true, std::memory_order_relaxed); }
+    inline void disable() { registry::instance().enabled.store(false, std::memory_order_relaxed); }
+    inline bool enabled() { return registry::instance().enabled.load(std::memory_order_relaxed); }
+
+    // Drop the recorded events; no sort may be running.
+    inline void clear()
+    {
+      for (ring *r : registry::instance().rings()) r->clear();
+    }
+
+    inline uint64_t now() { return registry::instance().now(); }
+
+    // A span of n elements from begin to now
+    inline void complete(const char *name, uint64_t begin, size_t n)
+    {
+      registry &reg = registry::instance();
+      if (!enabled()) return;
+      uint64_t t = reg.now();
+      reg.local().push(event{name, 'X', begin, t - begin, uint64_t(n)});
+    }
+
+    // The start of a flow at the spawn of a task; its id (0 if disabled)
+    inline uint64_t spawn()
+    {
+      registry &reg = registry::instance();
+      if (!enabled()) return 0;
+      uint64_t id = reg.next_flow.fetch_add(1, std::memory_order_relaxed);
+      reg.local().push(event{"spawn", 's', reg.now(), 0, id});
+      return id;
+    }
+
+    // The end of the flow when the task starts on a thread
+    inline void start(uint64_t id)
+    {
+      registry &reg = registry::instance();
+      if (id == 0 || !enabled()) return;
+      reg.local().push(event{"spawn", 'f', reg.now(), 0, id});
+    }
+
+
+    // ======================================================
+    // Output
+    // ======================================================
+
+    // Write the events of all the threads as a Chrome trace (JSON) to f.
+    inline void write_chrome_trace(FILE *f)
+    {
+      std::fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+      const char *sep = "";
+      for (ring *r : registry::instance().rings()) {
+        std::fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+                     "\"args\": {\"name\": \"thread %u\"}}", sep, r->tid(), r->tid());
+        sep = ",\n";
+        uint64_t head = r->head();
+        uint64_t i = head > ring_capacity ? head - ring_capacity : 0;
+        for (; i < head; i++) {
+          const event &e = r->at(i);
+          std::fprintf(f, "%s{\"name\": \"%s\", \"cat\": \"quicksort_mm\", \"ph\": \"%c\", \"pid\": 1, \"tid\": %u, "
+                       "\"ts\": %.3f", sep, e.name, e.ph, r->tid(), double(e.ts) * 1e-3);
+          if (e.ph == 'X') {
+            std::fprintf(f, ", \"dur\": %.3f, \"args\": {\"n\": %llu}}", double(e.dur) * 1e-3, (unsigned long long)e.arg);
+          }
+          else {
+            std::fprintf(f, ", \"id\": %llu%s}", (unsigned long long)e.arg, e.ph == 'f' ? ", \"bp\": \"e\"" : "");
+          }
+        }
+      }
+      std::fprintf(f, "\n]}\n");
+    }
+
+    // Write to the file of path; it returns false on failure.
+    inline bool write_chrome_trace(const std::string &path)
+    {
+      FILE *f = std::fopen(path.c_str(), "w");
+      if (!f) return false;
+      write_chrome_trace(f);
+      return std::fclose(f) == 0;
+    }
+  }
+}
+
+// The hooks in the parallel sorts
+// Without QUICKSORT_MM_TRACE, quicksort_mm_async.hh defines them as no-ops.
+#ifdef QUICKSORT_MM_TRACE
+#define QUICKSORT_MM_TRACE_BEGIN(t) uint64_t t = ::quicksort_mm::trace::now()
+#define QUICKSORT_MM_TRACE_END(name, t, n) ::quicksort_mm::trace::complete(name, t, n)
+#define QUICKSORT_MM_TRACE_SPAWN() ::quicksort_mm::trace::spawn()
+#define QUICKSORT_MM_TRACE_START(id) ::quicksort_mm::trace::start(id)
+#endif
+
+#endif
@@ -0,0 +1,944 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Checks of the C++ headers in src/cc.
+//
+// The routines are run on the edge cases (empty and single element
+// ranges, all-equal keys, k at the ends, ...) and their results are
+// compared with the standard library. Each failure is printed, and the
+// exit status is 1 if there is any. Build it with the sanitizers, so
+// that the memory errors are caught as well:
+//
+//   c++ -std=c++17 -g -fsanitize=address,undefined -Isrc/cc test/check.cc -o check -lpthread
+//   ./check
+//
+// C++17 is needed by quicksort_mm_chunked.hh; with -std=c++20, the
+// three-way comparators and the sorts at compile time are checked as well.
+// ======================================================
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
+#include "quicksort_mm_chunked.hh"
+#include "quicksort_mm_strided.hh"
+#include "quicksort_mm_kdtree.hh"
+#include "quicksort_mm_eytzinger.hh"
+#include "quicksort_mm_kll.hh"
+#include "quicksort_mm_resumable.hh"
+#include "quicksort_mm_async.hh"
+#include "quicksort_mm_batch.hh"
+#include "quicksort_mm_hint.hh"
+
+namespace {
+  int failures = 0;
+
+  void check(bool ok, const char *what, const char *file, int line)
+  {
+    if (ok) return;
+    std::printf("%s:%d: check failed: %s\n", file, line, what);
+    failures++;
+  }
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+  // The sizes of the inputs, around the cutoffs of the routines
+  const size_t sizes[] = {0, 1, 2, 3, 7, 16, 100, 1500, 40000};
+
+  enum pattern {
+    random_keys,   // few duplicates
+    few_keys,      // many duplicates
+    all_equal,
+    ascending,
+    descending,
+    npatterns
+  };
+
+  std::vector<int> make_input(size_t n, int p, unsigned seed = 1)
+  {
+    std::mt19937 rng(seed);
+    std::vector<int> v(n);
+    for (size_t i = 0; i < n; i++) {
+      switch (p) {
+      case random_keys: v[i] = int(rng() % 1000000); break;
+      case few_keys: v[i] = int(rng() % 3); break;
+      case all_equal: v[i] = 7; break;
+      case ascending: v[i] = int(i); break;
+      default: v[i] = int(n - i); break;
+      }
+    }
+    return v;
+  }
+
+  template<class T>
+  std::vector<T> sorted(std::vector<T> v)
+  {
+    std::sort(v.begin(), v.end());
+    return v;
+  }
+
+  // The same elements in any order
+  template<class T>
+  bool same_elements(const std::vector<T> &a, const std::vector<T> &b)
+  {
+    return sorted(a) == sorted(b);
+  }
+
+
+#if __cplusplus >= 202002L
+  // ======================================================
+  // quicksort_mm.hh: constexpr
+  //
+  // The routines are run at compile time by static_assert, so that the
+  // build fails if anything used by them is not constexpr. The arrays
+  // are long enough for the median of medians (s*30 <= N).
+  // ======================================================
+  constexpr size_t constexpr_size = 1000;
+
+  constexpr std::array<int, constexpr_size> constexpr_input()
+  {
+    std::array<int, constexpr_size> a{};
+    unsigned x = 1;
+    for (auto &v : a) {
+      x = x * 1103515245u + 12345u;
+      v = int(x >> 16) % 100;
+    }
+    return a;
+  }
+
+  template<class Compare>
+  constexpr bool constexpr_sorts(Compare cmp)
+  {
+    auto a = constexpr_input();
+    quicksort_mm::quicksort(a.begin(), a.end(), cmp);
+    for (size_t i = 1; i < a.size(); i++) {
+      if (a[i] < a[i-1]) return false;
+    }
+    return true;
+  }
+
+  constexpr bool constexpr_selects(size_t k)
+  {
+    auto a = constexpr_input();
+    quicksort_mm::quickselect(a.begin(), a.begin() + k, a.end());
+    for (size_t i = 0; i < a.size(); i++) {
+      if (i < k ? a[k] < a[i] : a[i] < a[k]) return false;
+    }
+    auto b = constexpr_input();
+    auto eq = quicksort_mm::select_equal_range(b.begin(), b.begin() + k, b.end());
+    return b[k] == a[k] && eq.first <= b.begin() + k && b.begin() + k < eq.second;
+  }
+
+  static_assert(constexpr_sorts(std::less<int>()));
+  static_assert(constexpr_sorts(std::compare_three_way()));
+  static_assert(constexpr_selects(0));
+  static_assert(constexpr_selects(constexpr_size / 2));
+  static_assert(constexpr_selects(constexpr_size - 1));
+
+  // A table sorted at compile time
+  constexpr auto constexpr_table = [] {
+    std::array<int, 20> a = {19, 3, 7, 0, 12, 5, 18, 1, 9, 14, 2, 16, 6, 11, 4, 17, 8, 13, 10, 15};
+    quicksort_mm::quicksort(a.begin(), a.end());
+    return a;
+  }();
+  static_assert(constexpr_table.front() == 0 && constexpr_table.back() == 19);
+#endif
+
+
+  // ======================================================
+  // quicksort_mm.hh: sorting networks
+  // ======================================================
+
+  // The inputs of n elements: all the 0-1 inputs for small n (which
+  // suffice by the 0-1 principle), and random ones with and without
+  // duplicates.
+  std::vector<std::vector<int> > network_inputs(size_t n)
+  {
+    std::vector<std::vector<int> > inputs;
+    if (n <= 12) {
+      for (unsigned long bits = 0; bits < (1ul << n); bits++) {
+        std::vector<int> v(n);
+        for (size_t i = 0; i < n; i++) v[i] = int((bits >> i) & 1);
+        inputs.push_back(v);
+      }
+    }
+    for (unsigned t = 0; t < 60; t++) {
+      auto v = make_input(n, t % 2 ? random_keys : few_keys, t);
+      if (t % 3 == 0) {
+        for (auto &x : v) x &= 1;
+      }
+      inputs.push_back(v);
+    }
+    return inputs;
+  }
+
+  // The networks generated at run time by the constexpr functions
+  // behind sort<N> and select<K>, for every N and K
+  void check_network_generator()
+  {
+    typedef quicksort_mm::network_edge edge;
+    for (size_t n = 0; n <= quicksort_mm::network_max_size; n++) {
+      std::vector<edge> sorting(quicksort_mm::merge_exchange(n, nullptr));
+      CHECK(quicksort_mm::merge_exchange(n, sorting.data()) == sorting.size());
+      for (auto &e : sorting) CHECK(e.lo < e.hi && e.hi < n);
+
+      auto inputs = network_inputs(n);
+      std::vector<std::vector<int> > expected;
+      for (auto &in : inputs) expected.push_back(sorted(in));
+
+      for (size_t k = 0; k <= n; k++) {
+        // k == n is the sorting network itself.
+        auto edges = sorting;
+        size_t m = k < n ? quicksort_mm::prune_network(edges.data(), edges.size(), n, k) : edges.size();
+        CHECK(m <= sorting.size());
+        for (size_t i = 0; i < inputs.size(); i++) {
+          auto a = inputs[i];
+          for (size_t j = 0; j < m; j++) {
+            if (a[edges[j].hi] < a[edges[j].lo]) std::swap(a[edges[j].lo], a[edges[j].hi]);
+          }
+          CHECK(k < n ? a[k] == expected[i][k] : a == expected[i]);
+        }
+      }
+    }
+  }
+
+  template<size_t N, class T, class Compare>
+  bool network_sorts(const std::array<T, N> &a, Compare cmp)
+  {
+    auto expected = a;
+    std::sort(expected.begin(), expected.end(), cmp);
+    auto b = a;
+    quicksort_mm::sort(b, cmp);
+    return b == expected;
+  }
+
+  // select<K> for K = 0, N/2, N-1
+  template<size_t N, class T, class Compare>
+  bool network_selects(const std::array<T, N> &a, Compare cmp)
+  {
+    auto expected = a;
+    std::sort(expected.begin(), expected.end(), cmp);
+    auto b = a;
+    quicksort_mm::select<0>(b, cmp);
+    if (b[0] != expected[0]) return false;
+    b = a;
+    quicksort_mm::select<N/2>(b, cmp);
+    if (b[N/2] != expected[N/2]) return false;
+    b = a;
+    quicksort_mm::select<N-1>(b, cmp);
+    return b[N-1] == expected[N-1];
+  }
+
+  template<size_t N>
+  void check_network_sort()
+  {
+    for (auto &in : network_inputs(N)) {
+      std::array<int, N> a;
+      std::copy(in.begin(), in.end(), a.begin());
+      CHECK(network_sorts(a, std::less<int>()));
+    }
+  }
+
+  template<size_t N>
+  void check_network_select()
+  {
+    for (auto &in : network_inputs(N)) {
+      std::array<int, N> a;
+      std::copy(in.begin(), in.end(), a.begin());
+      CHECK(network_selects(a, std::less<int>()));
+    }
+
+    // The elements other than arithmetic ones are swapped.
+    std::mt19937 rng(static_cast<unsigned>(N));
+    std::array<std::pair<int, int>, N> b;
+    for (int t = 0; t < 10; t++) {
+      for (auto &x : b) x = std::make_pair(int(rng() % 5), int(rng() % 5));
+      CHECK(network_sorts(b, std::greater<std::pair<int, int> >()));
+      CHECK(network_selects(b, std::greater<std::pair<int, int> >()));
+    }
+  }
+
+  template<size_t... I>
+  void check_network_sorts(std::index_sequence<I...>)
+  {
+    (check_network_sort<I>(), ...);
+  }
+
+  void check_networks()
+  {
+    check_network_generator();
+
+    // sort<N> for every N, and select<K> for some
+    check_network_sorts(std::make_index_sequence<quicksort_mm::network_max_size + 1>());
+    check_network_select<1>();
+    check_network_select<2>();
+    check_network_select<9>();
+    check_network_select<17>();
+    check_network_select<33>();
+    check_network_select<quicksort_mm::network_max_size>();
+
+    // Longer ones by quicksort and quickselect
+    check_network_sort<quicksort_mm::network_max_size + 1>();
+    check_network_select<quicksort_mm::network_max_size + 1>();
+    check_network_sort<300>();
+    check_network_select<300>();
+  }
+
+
+  // ======================================================
+  // quicksort_mm.hh: std::deque
+  //
+  // The deque iterators of libstdc++ are partitioned chunk by chunk
+  // through their internal members; the ranges start and end in the
+  // middle of the chunks here, so that a change of the layout is caught.
+  // ======================================================
+
+  // An element of 200 bytes, two of which fill a chunk of libstdc++
+  struct wide {
+    int key;
+    int pad[49];
+
+    explicit wide(int k = 0) : key(k), pad() {}
+    bool operator<(const wide &w) const { return key < w.key; }
+    bool operator==(const wide &w) const { return key == w.key; }
+  };
+
+  int key_of(int x) { return x; }
+  int key_of(const wide &w) { return w.key; }
+
+  template<class T>
+  void check_deque_of(size_t max_size)
+  {
+    // Elements outside the range, at the front and the back
+    const size_t margins[] = {0, 1, 3, 130};
+    for (size_t n : sizes) {
+      if (n > max_size) continue;
+      for (int p = 0; p < npatterns; p++) {
+        auto input = make_input(n, p);
+        auto expected = sorted(input);
+        for (size_t front : margins) {
+          for (size_t back : margins) {
+            std::deque<T> d;
+            for (size_t i = 0; i < front; i++) d.push_front(T(-1));
+            for (int x : input) d.push_back(T(x));
+            for (size_t i = 0; i < back; i++) d.push_back(T(-2));
+            auto first = d.begin() + front, last = d.end() - back;
+
+            auto reset = [&] { std::transform(input.begin(), input.end(), first, [](int x) { return T(x); }); };
+            auto untouched = [&] {
+              return std::count(d.begin(), first, T(-1)) == std::ptrdiff_t(front)
+                && std::count(last, d.end(), T(-2)) == std::ptrdiff_t(back);
+            };
+
+            quicksort_mm::quicksort(first, last);
+            CHECK(std::equal(first, last, expected.begin(), [](const T &a, int b) { return key_of(a) == b; }));
+            CHECK(untouched());
+
+            if (n == 0) continue;
+            for (size_t k : {size_t(0), n/2, n-1}) {
+              reset();
+              quicksort_mm::quickselect(first, first + k, last);
+              CHECK(key_of(first[k]) == expected[k]);
+              CHECK(std::none_of(first, first + k, [&](const T &x) { return first[k] < x; }));
+              CHECK(std::none_of(first + k, last, [&](const T &x) { return x < first[k]; }));
+              CHECK(untouched());
+            }
+
+#if __cplusplus >= 202002L
+            reset();
+            quicksort_mm::quicksort(first, last, [](const T &a, const T &b) { return key_of(a) <=> key_of(b); });
+            CHECK(std::equal(first, last, expected.begin(), [](const T &a, int b) { return key_of(a) == b; }));
+            CHECK(untouched());
+#endif
+          }
+        }
+      }
+    }
+  }
+
+  void check_deque()
+  {
+    check_deque_of<int>(40000);
+    check_deque_of<wide>(1500);
+  }
+
+
+  // ======================================================
+  // quicksort_mm_chunked.hh
+  // ======================================================
+  void check_chunked()
+  {
+    // Sizes of the buffers, with empty ones anywhere
+    const std::vector<std::vector<size_t> > layouts = {
+      {}, {0}, {0, 0, 0}, {1}, {0, 1, 0}, {1, 1, 1}, {5, 0, 3}, {1000, 0, 1, 2500, 7}, {0, 40000, 0, 1}
+    };
+    for (auto &layout : layouts) {
+      size_t n = 0;
+      for (size_t s : layout) n += s;
+      for (int p = 0; p < npatterns; p++) {
+        auto input = make_input(n, p);
+        auto expected = sorted(input);
+
+        // The buffers are separate allocations.
+        std::vector<std::vector<int> > bufs;
+        std::vector<quicksort_mm::chunk<int> > chunks;
+        size_t offset = 0;
+        for (size_t s : layout) {
+          bufs.emplace_back(input.begin() + offset, input.begin() + offset + s);
+          offset += s;
+        }
+        for (auto &b : bufs) chunks.push_back(quicksort_mm::chunk<int>{b.data(), b.size()});
+
+        quicksort_mm::quicksort_chunks(chunks);
+        std::vector<int> result;
+        for (auto &b : bufs) result.insert(result.end(), b.begin(), b.end());
+        CHECK(result == expected);
+
+        // sort_chunks_into, from the unsorted buffers
+        offset = 0;
+        for (auto &b : bufs) {
+          std::copy(input.begin() + offset, input.begin() + offset + b.size(), b.begin());
+          offset += b.size();
+        }
+        std::vector<int> out(n);
+        CHECK(quicksort_mm::sort_chunks_into(chunks, out.begin()) == out.end());
+        CHECK(out == expected);
+        for (auto &b : bufs) CHECK(std::is_sorted(b.begin(), b.end()));
+
+#if __cplusplus >= 202002L
+        offset = 0;
+        for (auto &b : bufs) {
+          std::copy(input.begin() + offset, input.begin() + offset + b.size(), b.begin());
+          offset += b.size();
+        }
+        quicksort_mm::quicksort_chunks(chunks, std::compare_three_way());
+        result.clear();
+        for (auto &b : bufs) result.insert(result.end(), b.begin(), b.end());
+        CHECK(result == expected);
+#endif
+      }
+    }
+  }
+
+
+  // ======================================================
+  // quicksort_mm_strided.hh
+  // ======================================================
+  void check_strided()
+  {
+    const size_t shapes[][2] = {{1, 1}, {1, 5}, {2, 3}, {100, 1}, {100, 37}, {3000, 20}};
+    for (auto &shape : shapes) {
+      size_t rows = shape[0], cols = shape[1], ld = cols + 3;
+      for (int p = 0; p < npatterns; p++) {
+        auto a = make_input(rows * ld, p);
+        const auto original = a;
+
+        // The columns by the standard library
+        std::vector<std::vector<int> > columns(cols);
+        for (size_t j = 0; j < cols; j++) {
+          for (size_t i = 0; i < rows; i++) columns[j].push_back(a[i*ld + j]);
+          columns[j] = sorted(columns[j]);
+        }
+
+        for (size_t k : {size_t(0), rows/2, rows-1}) {
+          for (size_t block : {size_t(0), size_t(1), size_t(3), cols + 10}) {
+            std::vector<int> out;
+            quicksort_mm::select_columns(a.data(), rows, cols, ld, k, std::back_inserter(out), std::less<int>(), block);
+            CHECK(out.size() == cols);
+            for (size_t j = 0; j < cols && j < out.size(); j++) CHECK(out[j] == columns[j][k]);
+          }
+          CHECK(a == original);
+
+          // In place, on the last column
+          auto b = a;
+          quicksort_mm::quickselect_strided(b.data() + cols - 1, rows, std::ptrdiff_t(ld), k);
+          CHECK(b[k*ld + cols - 1] == columns[cols - 1][k]);
+        }
+
+        // k out of the range: nothing is written.
+        std::vector<int> out;
+        quicksort_mm::select_columns(a.data(), rows, cols, ld, rows, std::back_inserter(out));
+        CHECK(out.empty());
+      }
+    }
+  }
+
+
+  // ======================================================
+  // select_equal_range
+  // ======================================================
+
+  // [lo, hi) holds the elements equal to the k-th of expected (sorted),
+  // the ones before are less and the ones after are greater.
+  template<class It>
+  bool is_equal_range(const std::vector<int> &v, const std::vector<int> &expected, size_t k, It first, std::pair<It, It> r)
+  {
+    size_t lo = r.first - first, hi = r.second - first;
+    auto eq = std::equal_range(expected.begin(), expected.end(), expected[k]);
+    if (lo != size_t(eq.first - expected.begin()) || hi != size_t(eq.second - expected.begin())) return false;
+    if (v[k] != expected[k]) return false;
+    for (size_t i = 0; i < v.size(); i++) {
+      if (i < lo ? !(v[i] < v[k]) : i < hi ? v[i] != v[k] : !(v[k] < v[i])) return false;
+    }
+    return true;
+  }
+
+  void check_select_equal_range()
+  {
+    for (size_t n : sizes) {
+      if (n == 0) continue;
+      for (int p = 0; p < npatterns; p++) {
+        for (size_t k : {size_t(0), n/2, n-1}) {
+          auto v = make_input(n, p);
+          auto expected = sorted(v);
+          auto r = quicksort_mm::select_equal_range(v.begin(), v.begin() + k, v.end());
+          CHECK(is_equal_range(v, expected, k, v.begin(), r));
+          CHECK(same_elements(v, expected));
+
+#if __cplusplus >= 202002L
+          v = make_input(n, p);
+          r = quicksort_mm::select_equal_range(v.begin(), v.begin() + k, v.end(), std::compare_three_way());
+          CHECK(is_equal_range(v, expected, k, v.begin(), r));
+#endif
+        }
+      }
+    }
+  }
+
+
+  // ======================================================
+  // quicksort_mm_kdtree.hh
+  // ======================================================
+
+  // The points of the subtree over [lo, hi) are on the sides of its root.
+  bool is_kdtree(const quicksort_mm::kdtree<int> &t, size_t lo, size_t hi, size_t depth)
+  {
+    if (hi - lo <= 1) return true;
+    size_t m = t.root(lo, hi);
+    const int *x = t.coord(depth % t.dims);
+    for (size_t i = lo; i < m; i++) if (x[m] < x[i]) return false;
+    for (size_t i = m+1; i < hi; i++) if (x[i] < x[m]) return false;
+    return is_kdtree(t, lo, m, depth+1) && is_kdtree(t, m+1, hi, depth+1);
+  }
+
+  void check_kdtree()
+  {
+    for (size_t n : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(100), size_t(40000)}) {
+      for (size_t dims : {size_t(1), size_t(3)}) {
+        for (int p = 0; p < npatterns; p++) {
+          for (unsigned threads : {1u, 4u}) {
+            auto points = make_input(n * dims, p);
+            auto t = quicksort_mm::build_kdtree(points.data(), n, dims, threads);
+            CHECK(t.n == n && t.dims == dims);
+            CHECK(t.index.size() == n && t.coords.size() == n * dims);
+
+            // index is a permutation, and the coordinates are those of the points.
+            std::vector<size_t> index = sorted(t.index);
+            bool permutation = true, coords = true;
+            for (size_t i = 0; i < index.size(); i++) permutation = permutation && index[i] == i;
+            for (size_t i = 0; i < t.index.size(); i++) {
+              for (size_t d = 0; d < dims; d++) coords = coords && t.coord(d)[i] == points[t.index[i]*dims + d];
+            }
+            CHECK(permutation);
+            CHECK(coords);
+            if (permutation && coords) CHECK(is_kdtree(t, 0, n, 0));
+          }
+        }
+      }
+    }
+  }
+
+
+  // ======================================================
+  // quicksort_mm_eytzinger.hh
+  // ======================================================
+
+  // lower_bound of the layout agrees with std::lower_bound on sorted.
+  template<class Layout>
+  bool same_lower_bounds(const Layout &e, const std::vector<int> &sorted)
+  {
+    if (e.size() != sorted.size()) return false;
+    int lo = sorted.empty() ? 0 : sorted.front() - 1;
+    int hi = sorted.empty() ? 0 : sorted.back() + 1;
+    for (int x = lo; x <= hi; x += 1 + (hi - lo) / 500) {
+      size_t k = e.lower_bound(x);
+      auto it = std::lower_bound(sorted.begin(), sorted.end(), x);
+      if (it == sorted.end() ? k != 0 : k == 0 || e.node(k) != *it) return false;
+    }
+    return true;
+  }
+
+  void check_eytzinger()
+  {
+    for (size_t n : sizes) {
+      for (int p = 0; p < npatterns; p++) {
+        auto v = make_input(n, p);
+        auto expected = sorted(v);
+        auto e = quicksort_mm::sort_eytzinger(v.begin(), v.end());
+        CHECK(v == expected);
+        CHECK(same_lower_bounds(e, expected));
+
+#if __cplusplus >= 202002L
+        v = make_input(n, p);
+        auto e3 = quicksort_mm::sort_eytzinger(v.begin(), v.end(), std::compare_three_way());
+        CHECK(same_lower_bounds(e3, expected));
+#endif
+      }
+    }
+  }
+
+
+  // ======================================================
+  // quicksort_mm_kll.hh
+  // ======================================================
+  void check_kll()
+  {
+    typedef quicksort_mm::kll_sketch<int> sketch;
+
+    sketch empty;
+    CHECK(empty.empty() && empty.count() == 0 && empty.rank(0) == 0);
+    bool thrown = false;
+    try {
+      empty.quantile(0.5);
+    }
+    catch (const std::out_of_range &) {
+      thrown = true;
+    }
+    CHECK(thrown);
+
+    sketch one;
+    one.update(42);
+    CHECK(one.count() == 1 && one.quantile(0.0) == 42 && one.quantile(1.0) == 42);
+
+    sketch equal;
+    for (int i = 0; i < 100000; i++) equal.update(7);
+    CHECK(equal.quantile(0.0) == 7 && equal.quantile(0.5) == 7 && equal.quantile(1.0) == 7);
+
+    // 0, 1, ..., n-1 in a random order; the rank error is about 1.7/k.
+    const int n = 200000;
+    auto stream = make_input(n, ascending);
+    std::shuffle(stream.begin(), stream.end(), std::mt19937(3));
+    sketch a(200), b(200);
+    for (int i = 0; i < n; i++) (i % 2 ? a : b).update(stream[i]);
+    a.merge(b);
+    CHECK(a.count() == uint64_t(n));
+    for (double q : {0.01, 0.5, 0.99}) {
+      double x = a.quantile(q);
+      CHECK(x > (q - 0.05) * n && x < (q + 0.05) * n);
+      double r = double(a.rank(int(q * n)));
+      CHECK(r > (q - 0.05) * n && r < (q + 0.05) * n);
+    }
+
+    // Merging a sketch into itself doubles the weights.
+    auto median = a.quantile(0.5);
+    a.merge(a);
+    CHECK(a.count() == 2 * uint64_t(n));
+    CHECK(a.quantile(0.5) > median - 0.05 * n && a.quantile(0.5) < median + 0.05 * n);
+
+    // Serialization round trip, and broken data
+    auto bytes = a.serialize();
+    auto c = sketch::deserialize(bytes.data(), bytes.size());
+    CHECK(c.count() == a.count() && c.k() == a.k() && c.quantile(0.5) == a.quantile(0.5));
+    thrown = false;
+    try {
+      sketch::deserialize(bytes.data(), bytes.size() - 1);
+    }
+    catch (const std::invalid_argument &) {
+      thrown = true;
+    }
+    CHECK(thrown);
+  }
+
+
+  // ======================================================
+  // Cancellation
+  // ======================================================
+
+  // Cancel at the calls-th check.
+  struct cancel_after {
+    int *calls;
+    bool operator()() const { return --*calls < 0; }
+  };
+
+  void check_cancel()
+  {
+    for (size_t n : sizes) {
+      for (int p = 0; p < npatterns; p++) {
+        auto input = make_input(n, p);
+        auto expected = sorted(input);
+
+        auto v = input;
+        CHECK(quicksort_mm::quicksort(v.begin(), v.end(), std::less<int>(), quicksort_mm::never_cancel()));
+        CHECK(v == expected);
+
+        // Cancelled at once, and in the middle of the sort: the elements
+        // are kept, and a full sort finishes the array. The ranges shorter
+        // than cancel_check_size are not checked, and are completed.
+        for (int calls : {0, 2}) {
+          v = input;
+          int left = calls;
+          bool completed = quicksort_mm::quicksort(v.begin(), v.end(), std::less<int>(), cancel_after{&left});
+          CHECK(completed == (left >= 0));
+          if (calls == 0) CHECK(completed == (n < quicksort_mm::cancel_check_size));
+          CHECK(same_elements(v, input));
+          if (completed) CHECK(v == expected);
+          quicksort_mm::quicksort(v.begin(), v.end());
+          CHECK(v == expected);
+
+          if (n == 0) continue;
+          for (size_t k : {size_t(0), n-1}) {
+            v = input;
+            left = calls;
+            completed = quicksort_mm::quickselect(v.begin(), v.begin() + k, v.end(), std::less<int>(), cancel_after{&left});
+            CHECK(same_elements(v, input));
+            if (completed) CHECK(v[k] == expected[k]);
+            if (n < quicksort_mm::cancel_check_size) CHECK(completed);
+          }
+        }
+
+        // A deadline in the past
+        v = input;
+        quicksort_mm::deadline<> past = {std::chrono::steady_clock::now()};
+        CHECK(quicksort_mm::quicksort(v.begin(), v.end(), std::less<int>(), past) == (n < quicksort_mm::cancel_check_size));
+        CHECK(same_elements(v, input));
+      }
+    }
+  }
+
+
+  // ======================================================
+  // quicksort_mm_resumable.hh
+  // ======================================================
+  void check_resumable()
+  {
+    typedef std::vector<int>::iterator It;
+    for (size_t n : sizes) {
+      for (int p = 0; p < npatterns; p++) {
+        auto input = make_input(n, p);
+        auto expected = sorted(input);
+
+        // The smallest slices suspend the partitions at every element.
+        auto v = input;
+        quicksort_mm::resumable_sort<It> sorter(v.begin(), v.end());
+        size_t steps = 0;
+        while (!sorter.step_work(1)) {
+          steps++;
+          if (steps % 100000 == 0) CHECK(same_elements(v, input));
+        }
+        CHECK(sorter.done());
+        CHECK(v == expected);
+        CHECK(sorter.step_work(1));
+
+        v = input;
+        quicksort_mm::resumable_sort<It> timed(v.begin(), v.end());
+        while (!timed.step(std::chrono::microseconds(0))) {}
+        CHECK(v == expected);
+
+#if __cplusplus >= 202002L
+        v = input;
+        quicksort_mm::resumable_sort<It, std::compare_three_way> three_way(v.begin(), v.end());
+        while (!three_way.step_work(100)) {}
+        CHECK(v == expected);
+#endif
+      }
+    }
+  }
+
+
+  // ======================================================
+  // quicksort_mm_async.hh
+  // ======================================================
+
+  // An executor whose submit() throws after the given number of tasks
+  struct failing_executor {
+    quicksort_mm::thread_pool *pool;
+    int tasks;
+
+    void submit(std::function<void()> task)
+    {
+      if (tasks-- <= 0) throw std::runtime_error("submit");
+      pool->submit(std::move(task));
+    }
+  };
+
+  struct throwing_less {
+    bool operator()(int a, int b) const
+    {
+      if (a == 500000) throw std::runtime_error("comparator");
+      return a < b;
+    }
+  };
+
+  void check_async()
+  {
+    quicksort_mm::thread_pool pool(2);
+    for (size_t n : {size_t(0), size_t(1), size_t(2), size_t(1500), size_t(300000)}) {
+      for (int p = 0; p < npatterns; p++) {
+        auto input = make_input(n, p);
+        auto expected = sorted(input);
+
+        auto v = input;
+        quicksort_mm::async_sort(v.begin(), v.end()).get();
+        CHECK(v == expected);
+
+        v = input;
+        quicksort_mm::async_sort(v.begin(), v.end(), std::less<int>(), pool).get();
+        CHECK(v == expected);
+      }
+    }
+
+    // submit() throwing for the first task is rethrown by async_sort,
+    // and for the later tasks by the future.
+    auto input = make_input(300000, random_keys);
+    for (int tasks : {0, 1}) {
+      auto v = input;
+      failing_executor executor = {&pool, tasks};
+      bool thrown = false;
+      try {
+        quicksort_mm::async_sort(v.begin(), v.end(), std::less<int>(), executor).get();
+      }
+      catch (const std::runtime_error &) {
+        thrown = true;
+      }
+      CHECK(thrown);
+      CHECK(same_elements(v, input));
+    }
+
+    // An exception of the comparator goes to the future.
+    auto v = input;
+    v[v.size()/3] = 500000;
+    bool thrown = false;
+    try {
+      quicksort_mm::async_sort(v.begin(), v.end(), throwing_less(), pool).get();
+    }
+    catch (const std::runtime_error &) {
+      thrown = true;
+    }
+    CHECK(thrown);
+  }
+
+
+  // ======================================================
+  // quicksort_mm_batch.hh
+  // ======================================================
+  void check_batch()
+  {
+    quicksort_mm::thread_pool pool(3);
+
+    quicksort_mm::batch<int> empty(pool);
+    empty.run();
+    CHECK(empty.size() == 0);
+
+    // Small and large jobs, including the empty ones
+    std::vector<std::vector<int> > inputs;
+    for (size_t n : sizes) {
+      for (int p = 0; p < npatterns; p++) inputs.push_back(make_input(n, p, unsigned(inputs.size())));
+    }
+    inputs.push_back(make_input(100000, random_keys));
+    auto arrays = inputs;
+
+    quicksort_mm::batch<int> b(pool);
+    for (auto &a : arrays) b.add(a.data(), a.size());
+    CHECK(b.size() == arrays.size());
+    b.run();
+    CHECK(b.size() == 0);
+    bool all_sorted = true;
+    for (size_t i = 0; i < arrays.size(); i++) all_sorted = all_sorted && arrays[i] == sorted(inputs[i]);
+    CHECK(all_sorted);
+
+    // The exception of a comparator is rethrown after all the jobs
+    // finish, and the batch can be used again.
+    arrays = inputs;
+    arrays[30][0] = 500000;  // 100 elements
+    arrays.back()[0] = 500000;
+    quicksort_mm::batch<int, throwing_less> t(pool);
+    for (auto &a : arrays) t.add(a.data(), a.size());
+    bool thrown = false;
+    try {
+      t.run();
+    }
+    catch (const std::runtime_error &) {
+      thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(t.size() == 0);
+    auto v = inputs[31];
+    t.add(v.data(), v.size());
+    t.run();
+    CHECK(v == sorted(inputs[31]));
+  }
+
+
+  // ======================================================
+  // quicksort_mm_hint.hh
+  // ======================================================
+  void check_hint()
+  {
+    for (size_t n : sizes) {
+      for (int p = 0; p < npatterns; p++) {
+        quicksort_mm::pivot_hint<int> hint;
+        for (unsigned seed = 1; seed <= 3; seed++) {
+          auto v = make_input(n, p, seed);
+          auto expected = sorted(v);
+          quicksort_mm::quicksort(v.begin(), v.end(), hint);
+          CHECK(v == expected);
+          CHECK(hint.empty() == (n < hint.min_size));
+        }
+      }
+    }
+
+    // The hint of the same distribution is taken, and a stale one is
+    // detected; both sort correctly.
+    quicksort_mm::pivot_hint<int> hint;
+    for (unsigned seed = 1; seed <= 3; seed++) {
+      auto v = make_input(40000, random_keys, seed);
+      quicksort_mm::quicksort(v.begin(), v.end(), std::less<int>(), hint);
+      CHECK(std::is_sorted(v.begin(), v.end()));
+    }
+    CHECK(hint.hits() > 0);
+    auto v = make_input(40000, random_keys, 4);
+    for (auto &x : v) x /= 100;
+    quicksort_mm::quicksort(v.begin(), v.end(), std::less<int>(), hint);
+    CHECK(std::is_sorted(v.begin(), v.end()));
+    CHECK(hint.misses() > 0);
+  }
+}
+
+
+int main()
+{
+  check_networks();
+  check_deque();
+  check_chunked();
+  check_strided();
+  check_select_equal_range();
+  check_kdtree();
+  check_eytzinger();
+  check_kll();
+  check_cancel();
+  check_resumable();
+  check_async();
+  check_batch();
+  check_hint();
+  if (failures) {
+    std::printf("%d checks failed\n", failures);
+    return 1;
+  }
+  std::printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,418 @@
+// Written in 2026 by the quicksort_mm contributors
+//
+// This program is under the CC0 Public Domain Dedication 1.0.
+// See <http://creativecommons.org/publicdomain/zero/1.0/> for details.
+// This program is distributed without any warranty.
+
+
+// ======================================================
+// Checks of the C interface (src/c/quicksort_mm.h).
+//
+// The routines are run on the edge cases (empty and single element
+// arrays, all-equal keys, k at the ends, ...) and their results are
+// compared with qsort. Each failure is printed, and the exit status
+// is 1 if there is any. Build it with the sanitizers, so that the
+// memory errors are caught as well:
+//
+//   cc -std=c99 -g -fsanitize=address,undefined -DQUICKSORT_MM_ASYNC -D_POSIX_C_SOURCE=200809L
+//      -Isrc/c test/check_c.c src/c/quicksort_mm.c -o check_c -lpthread
+//   ./check_c
+//
+// The async sort is checked when QUICKSORT_MM_ASYNC is defined.
+// The same checks are run on the C interface of the C++ version:
+//
+//   c++ -std=c++11 -g -fsanitize=address,undefined -Isrc/c -Isrc/cc -c src/c/quicksort_mm_cc.cc
+//   cc -std=c99 -g -fsanitize=address,undefined -Isrc/c -c test/check_c.c
+//   c++ -fsanitize=address,undefined check_c.o quicksort_mm_cc.o -o check_cc
+//   ./check_cc
+// ======================================================
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quicksort_mm.h"
+
+static int failures = 0;
+
+static void check(int ok, const char *what, const char *file, int line)
+{
+  if (ok) return;
+  printf("%s:%d: check failed: %s\n", file, line, what);
+  failures++;
+}
+
+#define CHECK(cond) check((cond) != 0, #cond, __FILE__, __LINE__)
+
+// The sizes of the inputs, around the cutoffs of the routines
+static const size_t sizes[] = {0, 1, 2, 3, 7, 16, 100, 1500, 40000};
+#define NSIZES (sizeof sizes / sizeof sizes[0])
+
+enum {
+  RANDOM_KEYS,   // few duplicates
+  FEW_KEYS,      // many duplicates
+  ALL_EQUAL,
+  ASCENDING,
+  DESCENDING,
+  NPATTERNS
+};
+
+// xorshift32
+static uint32_t next_random(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static void make_input(int *v, size_t n, int p, uint32_t seed)
+{
+  for (size_t i = 0; i < n; i++) {
+    switch (p) {
+    case RANDOM_KEYS: v[i] = (int)(next_random(&seed) % 1000000); break;
+    case FEW_KEYS: v[i] = (int)(next_random(&seed) % 3); break;
+    case ALL_EQUAL: v[i] = 7; break;
+    case ASCENDING: v[i] = (int)i; break;
+    default: v[i] = (int)(n - i); break;
+    }
+  }
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+// The sorted copy of v by qsort; the caller frees it.
+static int *sorted_copy(const int *v, size_t n)
+{
+  int *s = malloc(n * sizeof(int) + 1);
+  if (n) memcpy(s, v, n * sizeof(int));
+  qsort(s, n, sizeof(int), cmp_int);
+  return s;
+}
+
+// v has the elements of expected (sorted) in any order.
+static int same_elements(const int *v, const int *expected, size_t n)
+{
+  int *s = sorted_copy(v, n);
+  int same = n == 0 || memcmp(s, expected, n * sizeof(int)) == 0;
+  free(s);
+  return same;
+}
+
+static int equal_arrays(const int *a, const int *b, size_t n)
+{
+  return n == 0 || memcmp(a, b, n * sizeof(int)) == 0;
+}
+
+
+// ======================================================
+// quicksort_mm_quickselect and quicksort_mm_select_equal_range
+// ======================================================
+
+// [lo, hi) holds the elements equal to the k-th of expected (sorted),
+// the ones before are less and the ones after are greater.
+static int is_equal_range(const int *v, const int *expected, size_t n, size_t k, size_t lo, size_t hi)
+{
+  size_t l = k, h = k+1;
+  while (l > 0 && expected[l-1] == expected[k]) l--;
+  while (h < n && expected[h] == expected[k]) h++;
+  if (lo != l || hi != h || v[k] != expected[k]) return 0;
+  for (size_t i = 0; i < n; i++) {
+    if (i < lo ? v[i] >= v[k] : i < hi ? v[i] != v[k] : v[i] <= v[k]) return 0;
+  }
+  return 1;
+}
+
+static void check_select(void)
+{
+  for (size_t s = 0; s < NSIZES; s++) {
+    size_t n = sizes[s];
+    int *input = malloc(n * sizeof(int) + 1);
+    int *v = malloc(n * sizeof(int) + 1);
+    for (int p = 0; p < NPATTERNS; p++) {
+      make_input(input, n, p, 1);
+      int *expected = sorted_copy(input, n);
+
+      memcpy(v, input, n * sizeof(int));
+      quicksort_mm_quicksort(v, n, sizeof(int), cmp_int);
+      CHECK(equal_arrays(v, expected, n));
+
+      size_t ks[3] = {0, n/2, n-1};
+      for (int i = 0; n > 0 && i < 3; i++) {
+        size_t k = ks[i];
+        memcpy(v, input, n * sizeof(int));
+        quicksort_mm_quickselect(v, n, sizeof(int), k, cmp_int);
+        CHECK(v[k] == expected[k]);
+        CHECK(same_elements(v, expected, n));
+
+        size_t lo, hi;
+        memcpy(v, input, n * sizeof(int));
+        quicksort_mm_select_equal_range(v, n, sizeof(int), k, cmp_int, &lo, &hi);
+        CHECK(is_equal_range(v, expected, n, k, lo, hi));
+        CHECK(same_elements(v, expected, n));
+      }
+
+      // k out of the range, or an output pointer missing
+      size_t lo = 0, hi = 0;
+      memcpy(v, input, n * sizeof(int));
+      quicksort_mm_select_equal_range(v, n, sizeof(int), n, cmp_int, &lo, &hi);
+      CHECK(lo == n && hi == n);
+      CHECK(equal_arrays(v, input, n));
+      quicksort_mm_select_equal_range(v, n, sizeof(int), 0, cmp_int, NULL, &hi);
+      quicksort_mm_select_equal_range(v, n, sizeof(int), 0, cmp_int, &lo, NULL);
+      CHECK(equal_arrays(v, input, n));
+      free(expected);
+    }
+    free(v);
+    free(input);
+  }
+}
+
+
+// ======================================================
+// The cancellable variants
+// ======================================================
+
+// Cancel at the *arg-th check.
+static int cancel_after(void *arg)
+{
+  int *calls = arg;
+  return --*calls < 0;
+}
+
+static void check_cancel(void)
+{
+  for (size_t s = 0; s < NSIZES; s++) {
+    size_t n = sizes[s];
+    int *input = malloc(n * sizeof(int) + 1);
+    int *v = malloc(n * sizeof(int) + 1);
+    for (int p = 0; p < NPATTERNS; p++) {
+      make_input(input, n, p, 2);
+      int *expected = sorted_copy(input, n);
+
+      // A null callback never cancels.
+      memcpy(v, input, n * sizeof(int));
+      CHECK(quicksort_mm_quicksort_cancellable(v, n, sizeof(int), cmp_int, NULL, NULL) == 0);
+      CHECK(equal_arrays(v, expected, n));
+      if (n > 0) {
+        memcpy(v, input, n * sizeof(int));
+        CHECK(quicksort_mm_quickselect_cancellable(v, n, sizeof(int), n-1, cmp_int, NULL, NULL) == 0);
+        CHECK(v[n-1] == expected[n-1]);
+      }
+
+      // Cancelled at once, and in the middle: the elements are kept.
+      // The arrays shorter than 1024 are not checked, and are completed.
+      for (int calls = 0; calls <= 2; calls += 2) {
+        int left = calls;
+        memcpy(v, input, n * sizeof(int));
+        int cancelled = quicksort_mm_quicksort_cancellable(v, n, sizeof(int), cmp_int, cancel_after, &left);
+        CHECK(cancelled == (left < 0));
+        if (calls == 0) CHECK(cancelled == (n >= 1024));
+        CHECK(same_elements(v, expected, n));
+        if (!cancelled) CHECK(equal_arrays(v, expected, n));
+
+        if (n == 0) continue;
+        left = calls;
+        memcpy(v, input, n * sizeof(int));
+        cancelled = quicksort_mm_quickselect_cancellable(v, n, sizeof(int), n/2, cmp_int, cancel_after, &left);
+        CHECK(cancelled == (left < 0));
+        CHECK(same_elements(v, expected, n));
+        if (!cancelled) CHECK(v[n/2] == expected[n/2]);
+      }
+      free(expected);
+    }
+    free(v);
+    free(input);
+  }
+}
+
+
+#ifdef QUICKSORT_MM_ASYNC
+// ======================================================
+// quicksort_mm_quicksort_async
+// ======================================================
+#include <pthread.h>
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int done;
+} completion;
+
+static void complete(void *arg)
+{
+  completion *c = arg;
+  pthread_mutex_lock(&c->mutex);
+  c->done++;
+  pthread_cond_broadcast(&c->cond);
+  pthread_mutex_unlock(&c->mutex);
+}
+
+// Wait for count calls of the callback.
+static void wait_for(completion *c, int count)
+{
+  pthread_mutex_lock(&c->mutex);
+  while (c->done < count) pthread_cond_wait(&c->cond, &c->mutex);
+  pthread_mutex_unlock(&c->mutex);
+}
+
+static void check_async(void)
+{
+  completion c = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0};
+  int calls = 0;
+
+  // Sorts of all the sizes at once on the shared pool
+  int *inputs[NSIZES*NPATTERNS], *arrays[NSIZES*NPATTERNS];
+  for (size_t s = 0; s < NSIZES; s++) {
+    for (int p = 0; p < NPATTERNS; p++) {
+      size_t i = s*NPATTERNS + (size_t)p, n = sizes[s];
+      inputs[i] = malloc(n * sizeof(int) + 1);
+      arrays[i] = malloc(n * sizeof(int) + 1);
+      make_input(inputs[i], n, p, 3);
+      memcpy(arrays[i], inputs[i], n * sizeof(int));
+      quicksort_mm_quicksort_async(arrays[i], n, sizeof(int), cmp_int, complete, &c);
+      calls++;
+    }
+  }
+  wait_for(&c, calls);
+  CHECK(c.done == calls);
+  for (size_t s = 0; s < NSIZES; s++) {
+    for (int p = 0; p < NPATTERNS; p++) {
+      size_t i = s*NPATTERNS + (size_t)p, n = sizes[s];
+      int *expected = sorted_copy(inputs[i], n);
+      CHECK(equal_arrays(arrays[i], expected, n));
+      free(expected);
+      free(arrays[i]);
+      free(inputs[i]);
+    }
+  }
+
+  // The pool is started again after a shutdown.
+  quicksort_mm_async_shutdown();
+  size_t n = 100000;
+  int *v = malloc(n * sizeof(int));
+  make_input(v, n, RANDOM_KEYS, 4);
+  int *expected = sorted_copy(v, n);
+  quicksort_mm_quicksort_async(v, n, sizeof(int), cmp_int, complete, &c);
+  wait_for(&c, ++calls);
+  CHECK(equal_arrays(v, expected, n));
+  quicksort_mm_async_shutdown();
+  free(expected);
+  free(v);
+}
+#endif
+
+
+// ======================================================
+// Element sizes
+//
+// The C++ version dispatches the sizes 1, 2, 4, 8, 16 and 32 to the
+// fixed-size elements (without alignment for the misaligned arrays),
+// and sorts the others as records of the size given at run time; all of
+// them are checked against qsort.
+// ======================================================
+
+// Alignment of a type, without C11
+#define ALIGNMENT_OF(type) offsetof(struct { char c; type x; }, x)
+
+static size_t record_size;
+
+static int cmp_record(const void *a, const void *b)
+{
+  return memcmp(a, b, record_size);
+}
+
+static int cmp_long_double(const void *a, const void *b)
+{
+  CHECK((uintptr_t)a % ALIGNMENT_OF(long double) == 0 && (uintptr_t)b % ALIGNMENT_OF(long double) == 0);
+  long double x = *(const long double *)a, y = *(const long double *)b;
+  return (x > y) - (x < y);
+}
+
+static int cmp_long_long(const void *a, const void *b)
+{
+  CHECK((uintptr_t)a % ALIGNMENT_OF(long long) == 0 && (uintptr_t)b % ALIGNMENT_OF(long long) == 0);
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static void check_element_sizes(void)
+{
+  static const size_t record_sizes[] = {1, 2, 3, 4, 8, 12, 16, 24, 32, 40, 100, 300};
+  static const size_t counts[] = {0, 1, 2, 100, 5000};
+  for (size_t r = 0; r < sizeof record_sizes / sizeof record_sizes[0]; r++) {
+    for (size_t c = 0; c < sizeof counts / sizeof counts[0]; c++) {
+      size_t sz = record_sizes[r], n = counts[c];
+      // One byte more, for the misaligned array
+      char *input = malloc(n*sz + 1);
+      char *expected = malloc(n*sz + 1);
+      char *v = malloc(n*sz + 1);
+      uint32_t seed = 5;
+      // Few distinct bytes, so that there are equal records.
+      for (size_t i = 0; i < n*sz; i++) input[i] = (char)(next_random(&seed) % 3);
+      record_size = sz;
+      memcpy(expected, input, n*sz);
+      qsort(expected, n, sz, cmp_record);
+
+      for (size_t offset = 0; offset <= 1; offset++) {
+        char *a = v + offset;
+        memcpy(a, input, n*sz);
+        quicksort_mm_quicksort(a, n, sz, cmp_record);
+        CHECK(n == 0 || memcmp(a, expected, n*sz) == 0);
+
+        if (n == 0) continue;
+        memcpy(a, input, n*sz);
+        quicksort_mm_quickselect(a, n, sz, n/2, cmp_record);
+        CHECK(memcmp(a + n/2*sz, expected + n/2*sz, sz) == 0);
+
+        // The range of the last element
+        size_t lo, hi, expected_lo = n-1;
+        while (expected_lo > 0 && memcmp(expected + (expected_lo-1)*sz, expected + (n-1)*sz, sz) == 0) expected_lo--;
+        memcpy(a, input, n*sz);
+        quicksort_mm_select_equal_range(a, n, sz, n-1, cmp_record, &lo, &hi);
+        CHECK(lo == expected_lo && hi == n);
+        CHECK(memcmp(a + (n-1)*sz, expected + (n-1)*sz, sz) == 0);
+      }
+      free(v);
+      free(expected);
+      free(input);
+    }
+  }
+
+  // The copies passed to the comparator are aligned for the elements.
+  size_t n = 1500;
+  long double *x = malloc(n * sizeof *x);
+  long long *y = malloc(n * sizeof *y);
+  uint32_t seed = 6;
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (long double)(next_random(&seed) % 1000);
+    y[i] = (long long)(next_random(&seed) % 1000);
+  }
+  quicksort_mm_quicksort(x, n, sizeof *x, cmp_long_double);
+  quicksort_mm_quicksort(y, n, sizeof *y, cmp_long_long);
+  for (size_t i = 1; i < n; i++) CHECK(x[i-1] <= x[i] && y[i-1] <= y[i]);
+  free(y);
+  free(x);
+}
+
+
+int main(void)
+{
+  check_select();
+  check_cancel();
+#ifdef QUICKSORT_MM_ASYNC
+  check_async();
+#endif
+  check_element_sizes();
+  if (failures) {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}